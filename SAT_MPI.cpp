@@ -5,6 +5,13 @@
 #include <sstream> // for std::istringstream
 #include "core/get_time.h"
 #include "core/utils.h"
+#include "core/assignment.h"
+#include "core/clause_arena.h"
+#include "core/dimacs.h"
+#include "core/preprocess.h"
+#include "core/propagator.h"
+#include "core/dpll.h"
+#include "core/occurrences.h"
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -14,6 +21,7 @@
 #include <condition_variable>
 #include <queue>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -27,23 +35,26 @@
 
 #include <mpi.h>
 
-// Define a Clause as a vector of integers, where each integer represents a variable
-// Positive values denote the variable, and negative values denote its negation.
-typedef std::vector<int> Clause;
-// Define a Formula as a vector of Clauses
-typedef std::vector<Clause> Formula;
+// A Formula is a flat clause arena: each clause is a run of integers in one shared literal pool,
+// where positive values denote the variable, and negative values denote its negation.
+typedef ClauseArena Formula;
 
 std::atomic<bool> found_solution{false};
 std::atomic<bool> all_workers_should_stop{false};
 
+// Clauses removed by preprocessing, to extend the model of the simplified formula
+ReconstructionStack reconstruction;
+
 std::vector<int> completedTask;
 
+// A task is a subtree of the search, identified by the guiding path leading to it.
+// When a worker reports a solution the task also carries the satisfying assignment, packed.
 struct Task {
-    Formula formula;
-    std::map<int, std::optional<bool>> assignment;
+    GuidingPath path;
+    PackedAssignment assignment;
 
-    Task(Formula f, std::map<int, std::optional<bool>> a)
-        : formula(f), assignment(a) {}
+    Task(GuidingPath p)
+        : path(p) {}
 
     Task() = default;
 };
@@ -52,29 +63,17 @@ struct Task {
 std::vector<char> serializeTask(const Task& task) {
     std::vector<char> buffer;
 
-    // Serialize Formula
-    size_t numClauses = task.formula.size();
-    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&numClauses), reinterpret_cast<const char*>(&numClauses + 1));
-    for (const auto& clause : task.formula) {
-        size_t clauseSize = clause.size();
-        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&clauseSize), reinterpret_cast<const char*>(&clauseSize + 1));
-        for (int literal : clause) {
-            buffer.insert(buffer.end(), reinterpret_cast<const char*>(&literal), reinterpret_cast<const char*>(&literal + 1));
-        }
-    }
-    
-    // Serialize Assignment Map
-    size_t mapSize = task.assignment.size();
-    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&mapSize), reinterpret_cast<const char*>(&mapSize + 1));
-    for (const auto& [key, opt_val] : task.assignment) {
-        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&key), reinterpret_cast<const char*>(&key + 1));
-        bool hasValue = opt_val.has_value();
-        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&hasValue), reinterpret_cast<const char*>(&hasValue + 1));
-        if (hasValue) {
-            bool value = *opt_val;
-            buffer.insert(buffer.end(), reinterpret_cast<const char*>(&value), reinterpret_cast<const char*>(&value + 1));
-        }
-    }
+    // Serialize the guiding path
+    size_t pathSize = task.path.size();
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&pathSize), reinterpret_cast<const char*>(&pathSize + 1));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(task.path.data()), reinterpret_cast<const char*>(task.path.data() + pathSize));
+
+    // Serialize the packed assignment, two bits per variable
+    int numVariables = task.assignment.numVariables();
+    size_t numWords = task.assignment.words.size();
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&numVariables), reinterpret_cast<const char*>(&numVariables + 1));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&numWords), reinterpret_cast<const char*>(&numWords + 1));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(task.assignment.words.data()), reinterpret_cast<const char*>(task.assignment.words.data() + numWords));
 
     return buffer;
 }
@@ -85,36 +84,21 @@ Task deserializeTask(const std::vector<char>& buffer) {
     size_t pos = 0;
     Task task;
     
-    // Deserialize the formula
-    size_t numClauses = *reinterpret_cast<const size_t*>(buffer.data() + pos);
+    // Deserialize the guiding path
+    size_t pathSize = *reinterpret_cast<const size_t*>(buffer.data() + pos);
     pos += sizeof(size_t);
-    task.formula.resize(numClauses);
-    for (auto& clause : task.formula) {
-        size_t clauseSize = *reinterpret_cast<const size_t*>(buffer.data() + pos);
-        pos += sizeof(size_t);
-        clause.resize(clauseSize);
-        for (int& literal : clause) {
-            literal = *reinterpret_cast<const int*>(buffer.data() + pos);
-            pos += sizeof(int);
-        }
-    }
-    
-    // Deserialize the assignment map
-    size_t mapSize = *reinterpret_cast<const size_t*>(buffer.data() + pos);
+    const int* path = reinterpret_cast<const int*>(buffer.data() + pos);
+    task.path.assign(path, path + pathSize);
+    pos += pathSize * sizeof(int);
+
+    // Deserialize the packed assignment
+    task.assignment.n = *reinterpret_cast<const int*>(buffer.data() + pos);
+    pos += sizeof(int);
+    size_t numWords = *reinterpret_cast<const size_t*>(buffer.data() + pos);
     pos += sizeof(size_t);
-    for (size_t i = 0; i < mapSize; ++i) {
-        int key = *reinterpret_cast<const int*>(buffer.data() + pos);
-        pos += sizeof(int);
-        bool hasValue = *reinterpret_cast<const bool*>(buffer.data() + pos);
-        pos += sizeof(bool);
-        std::optional<bool> opt_val;
-        if (hasValue) {
-            bool value = *reinterpret_cast<const bool*>(buffer.data() + pos);
-            pos += sizeof(bool);
-            opt_val = value;
-        }
-        task.assignment[key] = opt_val;
-    }
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(buffer.data() + pos);
+    task.assignment.words.assign(words, words + numWords);
+    pos += numWords * sizeof(uint64_t);
 
     return task;
 }
@@ -197,294 +181,125 @@ public:
 
 std::queue<std::shared_ptr<Task>> taskQueue;  // Global task queue managed by the master
 
-// Function to read a CNF file in DIMACS format and populate the formula
-bool readDIMACSCNF(const std::string& filename, Formula& formula, int& numVariables) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filename << std::endl;
-        return false;
-    }
-
-    std::string line;
-    int numClauses;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == 'c') continue; // Skip comments and empty lines
-        if (line[0] == 'p') {
-            std::istringstream iss(line);
-            std::string tmp;
-            if (!(iss >> tmp >> tmp >> numVariables >> numClauses)) {
-                std::cerr << "Error reading header line: " << line << std::endl;
-                return false;
-            }
-            formula.reserve(numClauses); // Reserve space for clauses
-            continue;
-        }
-        std::istringstream iss(line);
-        Clause clause;
-        int lit;
-        while (iss >> lit && lit != 0) { // Read literals until 0
-            clause.push_back(lit);
-        }
-        if (!clause.empty()) formula.push_back(clause);
-    }
-    return true;
-}
-
-// Helper function to get unassigned keys from the assignment map
-std::set<int> getUnassignedKeys(const std::map<int, std::optional<bool>>& assignment) {
-    std::set<int> keys;
-    
-    // Iterate over the map and check for keys with a std::nullopt value
-    for (const auto& [key, val] : assignment) {
-        if (!val.has_value()) {  // Equivalent to checking if val is std::nullopt
-            keys.insert(key);
-        }
-    }
-    // Sort the keys
-    // std::sort(keys.begin(), keys.end());
-
-    return keys;
-}
-
 // Simplify the formula based on the current assignments
-Formula simplifyFormula(const Formula& formula, 
-                        std::map<int, std::optional<bool>>& assignment) {
-    Formula newFormula;
-
-    for (const auto& clause : formula) {
-        bool satisfied = false;
-        for (int lit : clause) {
-            if (lit > 0) {
-                if (assignment.count(lit) && assignment[lit] == std::optional<bool>(true)) {
-                    satisfied = true;
-                    break;
-                }
-            } else {
-                if (assignment.count(std::abs(lit)) && assignment[std::abs(lit)] == std::optional<bool>(false)) {
-                    satisfied = true;
-                    break;
-                }
-            }
-        }
-        if (!satisfied) {
-            newFormula.push_back(clause);
+// The literals assigned since the last node update the satisfied-clause and live-occurrence counters
+// through their occurrence lists; unassigned variables left in no unsatisfied clause are set to true
+void simplifyFormula(DPLLSearch& search) {
+    ClauseState& live = search.live;
+    const Assignment& assignment = search.engine.assignment;
+    live.sync(search.engine.trail);
+
+    // For each candidate lit if its potive lit and negative lit are both gone from the unsatisfied clauses then set it to true (as we don't need it)
+    for (int var : live.candidates) {
+        if (!assignment.isAssigned(var) && live.liveCount(var) == 0 && live.liveCount(-var) == 0) {
+            search.engine.enqueue(var);
         }
     }
-
-    auto unassignedKeys = getUnassignedKeys(assignment);
-
-    // Push all lit in the new Formula to keyInFormula
-    std::vector<int> keyInFormula;
-    for (const auto& clause : newFormula) {
-        for (int lit : clause) {
-            // If lit not already in keyInFormula, then push it in
-            if (std::find(keyInFormula.begin(), keyInFormula.end(), lit) == keyInFormula.end()) {
-                keyInFormula.push_back(lit);
-            }
-        }
-    }
-
-    // For each unassigned lit if its potive lit and negative lit all NOT found in varInFormula then set it to true (as we don't need it)
-    for (int key : unassignedKeys) {
-        if (std::find(keyInFormula.begin(), keyInFormula.end(), key) == keyInFormula.end() &&
-            std::find(keyInFormula.begin(), keyInFormula.end(), -key) == keyInFormula.end()) {
-            assignment[std::abs(key)] = std::optional<bool>(true);
-        }
-    }
-
-    return newFormula;
 }
 
 
-uint countAssigned(const std::map<int, std::optional<bool>>& assignment){
-    uint count = 0;
-    for (const auto& [key, val] : assignment) {
-        if (val.has_value()) {  // Equivalent to checking if val is std::nullopt
-            count++;
-        }
-    }
-    return count;
-}
-
 // See if by assigning clauses with only one missing value can satisfy, return true if unit clause is satisfiable
-bool unitPropagation(Formula& formula, std::map<int, std::optional<bool>>& assignment) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto& clause : formula) {
-            int unassignedCount = 0;
-            int lastUnassignedLit = 0;
-            for (int lit : clause) {
-                // Count the unassigned lit number in the clause 
-                if (!assignment[std::abs(lit)].has_value()) {
-                    unassignedCount++;
-                    lastUnassignedLit = lit;
-                } 
-                // Else see if the clause satisfy, if statisfied set count to -1
-                else if ((lit > 0 && assignment[std::abs(lit)] == true) ||
-                           (lit < 0 && assignment[std::abs(lit)] == false)) {
-                    unassignedCount = -1; // Clause is already satisfied, to next clause
-                    break;
-                }
-            }
-            // If only 1 unassigned lit in the clause, assign the value
-            if (unassignedCount == 1) { // This is a unit clause
-                assignment[std::abs(lastUnassignedLit)] = (lastUnassignedLit > 0);
-                changed = true;
-            } 
-            // Else if clause cannot be satisfied
-            else if (unassignedCount == 0) {
-                // std::cout << "Dead end" << "\n";
-                return false; // Clause cannot be satisfied, then means this path FAILS
-            }
-        }
+// Only the clauses watching a literal that just became false are visited.
+bool unitPropagation(DPLLSearch& search) {
+    ClauseRef confl = search.engine.propagate();
+    if (confl != CLAUSE_REF_UNDEF) {
+        search.conflict(confl);
+        return false; // Clause cannot be satisfied, then means this path FAILS
     }
     return true;
 }
 
-void pureLiteralElimination(Formula& formula, std::map<int, std::optional<bool>>& assignment) {
-    // std::map<int, int> polarity;
-    // for (auto& clause : formula) {
-    //     for (int lit : clause) {
-    //         if (!assignment[std::abs(lit)].has_value()) {
-    //             polarity[lit]++;
-    //         }
-    //     }
-    // }
-
-    // for (auto& p : polarity) {
-    //     if (polarity[-p.first] == 0 && p.second != 0) { // Pure literal found
-    //         assignment[std::abs(p.first)] = (p.first > 0);
-    //     }
-    // }
-
-
-    std::map<int, int> polarity;
-    std::set<int> consideredLiterals = getUnassignedKeys(assignment);
-    for (auto& clause : formula) {
-        for (int lit : clause) {
-            int abs_lit = std::abs(lit);
-            if (!assignment[abs_lit].has_value() && consideredLiterals.find(abs_lit) != consideredLiterals.end()) {
-                polarity[lit]++;
-                // consideredLiterals.insert(abs_lit);
-            }
+// Pure literals are looked for only among the candidate variables whose live occurrences just changed
+void pureLiteralElimination(DPLLSearch& search) {
+    ClauseState& live = search.live;
+    const Assignment& assignment = search.engine.assignment;
+    live.sync(search.engine.trail);
+
+    for (int var : live.candidates) {
+        if (assignment.isAssigned(var)) continue;
+        if (live.liveCount(var) > 0 && live.liveCount(-var) == 0) {  // Only positive literals are present
+            search.engine.enqueue(var);
+        } else if (live.liveCount(-var) > 0 && live.liveCount(var) == 0) {  // Only negative literals are present
+            search.engine.enqueue(-var);
         }
     }
+    live.candidates.clear();
+}
 
-    // Test
-    // for (auto& p : polarity) {
-    //     // if (polarity[-p.first] == 0 && p.second != 0) { // Pure literal found
-    //     //     assignment[std::abs(p.first)] = (p.first > 0);
-    //     // }
-    //     std::cout << p.first << "|" << p.second << "\n";
-    // }
-
-    for (int lit : consideredLiterals) {
-        if (polarity[lit] > 0 && polarity[-lit] == 0) {  // Only positive literals are present
-            assignment[std::abs(lit)] = true;
-        } else if (polarity[-lit] > 0 && polarity[lit] == 0) {  // Only negative literals are present
-            assignment[std::abs(lit)] = false;
-        }
-    }
+// The formula is satisfied once every clause counts a true literal
+bool isFormulaSatisfied(DPLLSearch& search) {
+    search.live.sync(search.engine.trail);
+    return search.live.allSatisfied();
 }
 
-bool isFormulaSatisfied(const Formula& formula, const std::map<int, std::optional<bool>>& assignment) {
-    for (const auto& clause : formula) {
-        bool satisfied = false;
-        for (int lit : clause) {
-            if ((lit > 0 && assignment.at(std::abs(lit)) == true) ||
-                (lit < 0 && assignment.at(std::abs(lit)) == false)) {
-                satisfied = true;
-                break;
-            }
-        }
-        if (!satisfied) return false;
+// Answer a split request from the master, if one arrived, with the open branch closest to the root.
+// Returns false if the master asked to abort the search because another worker found a solution.
+bool answerMaster(DPLLSearch& search) {
+    int pending;
+    MPI_Status status;
+    MPI_Iprobe(0, 5, MPI_COMM_WORLD, &pending, &status);
+    if (!pending) return true;
+
+    int request;
+    MPI_Recv(&request, 1, MPI_INT, 0, 5, MPI_COMM_WORLD, &status);
+    if (request < 0) return false;
+
+    GuidingPath path;
+    if (search.split(path)) {
+        sendTask(std::make_shared<Task>(path), 0, 2, MPI_COMM_WORLD); // tag 2 means new task submission
+    } else {
+        MPI_Send(&request, 0, MPI_INT, 0, 6, MPI_COMM_WORLD); // tag 6 means nothing to split
     }
     return true;
 }
 
-void makeDecisionAndSpawn(std::shared_ptr<Task> task) {
-    // Find the first unassigned variable
-    int variable = -1;
-    for (const auto& [var, val] : task->assignment) {
-        if (!val.has_value()) {
-            variable = var;
-            break;
-        }
-    }
-
-    if (variable != -1) {
-        // Create two new nodes for each possible value of the variable
-        for (bool val : {true, false}) {
-            std::map<int, std::optional<bool>> newAssignment = task->assignment;
-            newAssignment[variable] = val;
+// Branch on the variable picked by the decision heuristic, returns false if there is no variable left to branch on
+bool makeDecisionAndSpawn(DPLLSearch& search) {
+    // Ask the heuristic for an unassigned variable
+    const Assignment& assignment = search.engine.assignment;
+    int variable = search.heuristic->pickBranchVariable(assignment);
+    if (variable == 0) return false;
 
-            Formula newFormula = task->formula; // Copy formula to potentially simplify
-            // if (!unitPropagation(newFormula, newAssignment)) continue; // Skip unsatisfiable path
-
-            std::shared_ptr<Task> newTask = std::make_shared<Task>(newFormula, newAssignment);
-            // taskQueue.addTask(newNode);
-            // Send the new task over
-            sendTask(newTask, 0, 2, MPI_COMM_WORLD); // tag 2 means new task submission
-        }
-    } 
-    // If no available variable found
-    // else {
-    //     // All variables are assigned, check if the formula is satisfied
-    //     std::cout << "Dead end" << "\n";
-    // }
-    return;
+    // Explore the preferred polarity in place, the other branch stays open on the trail until the master asks for it
+    search.decide(search.branchLiteral(variable));
+    return true;
 }
 
 
-bool handleTask(std::shared_ptr<Task> task){
-        // std::cout << "START\n";
-        // for (const auto& [var, val] : task->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
+// Explore the subtree of the task in place, returns true if a solution was found (stored in the task)
+bool handleTask(std::shared_ptr<Task> task, DPLLSearch& search){
+    const Assignment& assignment = search.engine.assignment;
 
-        // PROCESS THE TASK
-        // If the current assignment does not satisfy, then skip
-        if (!unitPropagation(task->formula, task->assignment)) return false;
+    bool open = search.start(task->path);
+    while (open) {
+        if (!answerMaster(search)) return false;
 
-        // std::cout << "AFTER UNITPROP\n";
-        // for (const auto& [var, val] : task->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
+        // PROCESS THE NODE
+        // If the current assignment does not satisfy, then backtrack
+        if (!unitPropagation(search)) {
+            open = search.backtrack();
+            continue;
+        }
 
         // Simplfy the form
-        task->formula = simplifyFormula(task->formula, task->assignment);
+        simplifyFormula(search);
 
         // Liminate all pure literal
-        pureLiteralElimination(task->formula, task->assignment);
-
-        // std::cout << "AFTER PUREELIM\n";
-        // for (const auto& [var, val] : task->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
+        pureLiteralElimination(search);
 
         // Simplfy the form
-        task->formula = simplifyFormula(task->formula, task->assignment);
-
-        if (isFormulaSatisfied(task->formula, task->assignment)) {
-            // std::cout << "SATISFIABLE\n";
-            // for (const auto& [var, val] : task->assignment) {
-            //     if (val.has_value()) {
-            //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-            //     }
-            // }
+        simplifyFormula(search);
 
+        if (isFormulaSatisfied(search)) {
+            task->assignment.pack(assignment);
             return true;
         }
-        
-        makeDecisionAndSpawn(task);
-        return false;
+
+        if (!makeDecisionAndSpawn(search)) {
+            open = search.backtrack();
+        }
+    }
+    return false;
 }
 
 void master(uint world_size) {
@@ -495,6 +310,9 @@ void master(uint world_size) {
     std::vector<bool> active(world_size, true);  // Track active workers.
     int active_count = world_size - 1;
 
+    std::vector<bool> busy(world_size, false);          // Worker is exploring a subtree
+    std::vector<bool> split_pending(world_size, false); // Worker was asked to split and has not answered yet
+
     int remaining_workers = world_size-1;
 
     bool all_tasks_should_terminate = false;
@@ -506,10 +324,11 @@ void master(uint world_size) {
 
         // if (taskQueue.completed_task[thread_id] % 1000 == 0){
         //     std::cout << "Thread number  " << thread_id << ", numOfTask: "  << taskQueue.completed_task[thread_id] << "\n";
-        //     std::cout << "Assigned number:  " << countAssigned(task->assignment) << "\n";
+        //     std::cout << "Assigned number:  " << task->assignment.countAssigned() << "\n";
         // }
         if (status.MPI_TAG == 1 && all_tasks_should_terminate) {
             int source = status.MPI_SOURCE;
+            busy[source] = false;
             // std::cout << "Worker " << source << " want to term" << std::endl;
 
             int dummy;
@@ -525,6 +344,7 @@ void master(uint world_size) {
         else if (status.MPI_TAG == 1) {  // Tag 1 means task request
             int source = status.MPI_SOURCE;
             MPI_Recv(&flag, 1, MPI_INT, source, 1, MPI_COMM_WORLD, &status);  // Dummy receive to complete the probe
+            busy[source] = false;
             // Send a task if available
             if (!taskQueue.empty()) {
                 task = taskQueue.front();
@@ -532,15 +352,39 @@ void master(uint world_size) {
 
                 // Count 
                 completedTask[source]++;
+                busy[source] = true;
                 sendTask(task, source, 0, MPI_COMM_WORLD);  // Tag 0 means sending a task
+            } else if (std::find(busy.begin(), busy.end(), true) == busy.end() &&
+                       std::find(split_pending.begin(), split_pending.end(), true) == split_pending.end()) {
+                // Nothing queued, nobody exploring and no split on its way: every subtree was refuted
+                std::cout << "UNSATISFIABLE\n";
+                all_tasks_should_terminate = true;
+                int signal = -1;
+                MPI_Send(&signal, 1, MPI_INT, source, 3, MPI_COMM_WORLD);  // Tag 3 means termination
+                remaining_workers--;
             } else {
                 // Send a no-task signal, for example, by sending a special task or an empty message with a specific tag
                 MPI_Send(&flag, 0, MPI_INT, source, 2, MPI_COMM_WORLD);  // Tag 2 means no task available
+
+                // Ask one busy worker to split off part of its subtree
+                for (uint w = 1; w < world_size; w++) {
+                    if (busy[w] && !split_pending[w]) {
+                        int request = 1;
+                        MPI_Send(&request, 1, MPI_INT, w, 5, MPI_COMM_WORLD);  // Tag 5 means split request
+                        split_pending[w] = true;
+                        break;
+                    }
+                }
             }
         }
         else if (status.MPI_TAG == 2) {  // Tag 2 means new task submission
             task = recvTask(status.MPI_SOURCE, 2, MPI_COMM_WORLD);
-            taskQueue.push(task);
+            split_pending[status.MPI_SOURCE] = false;
+            if (!all_tasks_should_terminate) taskQueue.push(task);
+        }
+        else if (status.MPI_TAG == 6) {  // Tag 6 means the worker had nothing to split
+            MPI_Recv(&flag, 0, MPI_INT, status.MPI_SOURCE, 6, MPI_COMM_WORLD, &status);
+            split_pending[status.MPI_SOURCE] = false;
         }
         else if (status.MPI_TAG == 3 && !all_tasks_should_terminate) {  // Handle other types of messages, like termination
             int source = status.MPI_SOURCE;
@@ -549,14 +393,25 @@ void master(uint world_size) {
             std::cout << "Task completed" << "\n";
             all_tasks_should_terminate = true;
             remaining_workers--;
+            busy[source] = false;
+
+            // Make the workers still exploring a subtree give up on it
+            for (uint w = 1; w < world_size; w++) {
+                if (busy[w]) {
+                    int request = -1;
+                    MPI_Send(&request, 1, MPI_INT, w, 5, MPI_COMM_WORLD);
+                }
+            }
             
             std::shared_ptr<Task> task = recvTask(status.MPI_SOURCE, 4, MPI_COMM_WORLD);
 
+            // Every process preprocessed the same way, the master extends the model it received
+            Assignment model;
+            task->assignment.unpack(model);
+            reconstruction.extend(model);
             std::cout << "SATISFIABLE\n";
-            for (const auto& [var, val] : task->assignment) {
-                if (val.has_value()) {
-                    std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-                }
+            for (int var = 1; var <= model.numVariables(); var++) {
+                std::cout << "Variable " << var << " = " << (model.value(var) == VALUE_TRUE ? "True" : "False") << "\n";
             }
         }
         else if (status.MPI_TAG == 3){
@@ -579,24 +434,43 @@ void master(uint world_size) {
 // Tag 1: Task request
 // Tag 2: New task recieved             No Available task
 // Tag 3: Compelete                     Compelete
+// Tag 5:                               Split request (1) or abort subtree (-1)
+// Tag 6: Nothing to split
 
-void worker(uint rank, uint word_size) {
+void worker(uint rank, uint word_size, std::shared_ptr<const Formula> rootFormula, std::shared_ptr<const OccurrenceLists> occurrences, int numVariables) {
+    // Each worker explores its subtrees in place on its own trail over the original formula
+    DPLLSearch search(rootFormula, occurrences, numVariables);
+
+    bool requested = false;
     while (true) {
         // Request a task from the master
         int flag = 1;  // Dummy flag to signal a request
-        MPI_Send(&flag, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);  // Send request to master (rank 0) with tag 1
+        if (!requested) {
+            MPI_Send(&flag, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);  // Send request to master (rank 0) with tag 1
+            requested = true;
+        }
 
         // Receive the task or a signal that no task is available
         MPI_Status status;
         MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);  // Check source and tag
 
+        if (status.MPI_TAG == 5) {  // Split or abort request that raced with our task request
+            int request;
+            MPI_Recv(&request, 1, MPI_INT, 0, 5, MPI_COMM_WORLD, &status);
+            if (request > 0) {
+                MPI_Send(&request, 0, MPI_INT, 0, 6, MPI_COMM_WORLD);  // Idle, nothing to split
+            }
+            continue;  // Still waiting for the answer to our request
+        }
+        requested = false;
+
         if (status.MPI_TAG == 0) {  // Assuming tag 0 means a task is sent
             std::shared_ptr<Task> task = recvTask(0, 0, MPI_COMM_WORLD);
             // std::cout << "Worker " << rank << " received a task." << std::endl;
             
             // If found the solution terminate all threads
             // Process the task
-            if (handleTask(task)){
+            if (handleTask(task, search)){
                 MPI_Send(&flag, 1, MPI_INT, 0, 3, MPI_COMM_WORLD);  // Send termination signal to master (rank 0) with tag 3
                 // Send the task to master to print
                 sendTask(task, 0, 4, MPI_COMM_WORLD);
@@ -621,6 +495,39 @@ void worker(uint rank, uint word_size) {
 
 int main(int argc, char *argv[]) {
 
+    cxxopts::Options options(
+        "SAT_MPI",
+        "Solve sat_problem.cnf with a master process handing subtrees to worker processes");
+    options.add_options(
+        "",
+        {
+            {"preprocess", "Comma-separated preprocessing passes (subsume, equiv, probe, bve, bce), or none",
+            cxxopts::value<std::string>()->default_value(DEFAULT_PREPROCESS)},
+        });
+
+    auto cl_options = options.parse(argc, argv);
+    std::string passes = cl_options["preprocess"].as<std::string>();
+
+    MPI_Init(NULL, NULL);
+
+    // Get the number of processes
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    // Get the rank of the process
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+
+    // Every process sees the same options, so they all give up together
+    if (!validPreprocess(passes)) {
+        if (world_rank == 0) {
+            std::cout << "Unknown preprocessing pass in " << passes << ", expected subsume, equiv, probe, bve, bce or none" << std::endl;
+            std::cout << "Exiting." << std::endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
     std::string filename = "sat_problem.cnf"; 
     Formula formula;
     int numVariables = 0;
@@ -630,32 +537,21 @@ int main(int argc, char *argv[]) {
         std::cerr << "Failed to read CNF file." << std::endl;
         return 1;
     }
+    preprocess(formula, numVariables, passes, reconstruction, world_rank == 0);
+
+    // The simplified formula is read-only from now on, every search shares it
+    std::shared_ptr<const Formula> rootFormula = std::make_shared<const Formula>(std::move(formula));
+    std::shared_ptr<const OccurrenceLists> occurrences = std::make_shared<const OccurrenceLists>(*rootFormula, numVariables);
 
     timer t_mpi;
     t_mpi.start();
 
-    std::map<int, std::optional<bool>> initial_assignment;
-
-    // Initialize the map with keys from 1 to numVariables, all values set to std::nullopt
-    for (int i = 1; i <= numVariables; ++i) {
-        initial_assignment[i] = std::nullopt;
-    }
-
-    std::shared_ptr<Task> root = std::make_shared<Task>(formula, initial_assignment);
+    // The root task is the whole search tree, with an empty guiding path
+    std::shared_ptr<Task> root = std::make_shared<Task>(GuidingPath());
     taskQueue.push(root);
 
-    MPI_Init(NULL, NULL);
-
-    // Get the number of processes
-    int world_size;
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
-
     completedTask.resize(world_size);
 
-    // Get the rank of the process
-    int world_rank;
-    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
-
     if (world_size < 2 && world_rank == 0){
         std::cout << "Need at least two thread to maintain queue" << "\n";
         return -1;
@@ -676,7 +572,7 @@ int main(int argc, char *argv[]) {
     }
     else{
         // Start worker threads
-        worker(world_rank, world_size);
+        worker(world_rank, world_size, rootFormula, occurrences, numVariables);
     }
 
     double parallelTime = t_mpi.stop();
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include "core/get_time.h"
+#include "core/utils.h"
+#include "core/assignment.h"
+#include "core/clause_arena.h"
+#include "core/dimacs.h"
+#include "core/sls.h"
+
+#define DEFAULT_SEED "1"
+#define DEFAULT_MAX_FLIPS "0"
+
+// A Formula is a flat clause arena: each clause is a run of integers in one shared literal pool,
+// where positive values denote the variable, and negative values denote its negation.
+typedef ClauseArena Formula;
+
+int main(int argc, char *argv[]) {
+
+    cxxopts::Options options(
+        "SAT_SLS",
+        "Search sat_problem.cnf for a model with stochastic local search");
+    options.add_options(
+        "",
+        {
+            {"rule", "Flip rule, probsat or walksat",
+            cxxopts::value<std::string>()->default_value(DEFAULT_SLS_RULE)},
+            {"seed", "Random seed",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_SEED)},
+            {"maxFlips", "Give up after this many flips, 0 for no limit",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_MAX_FLIPS)},
+        });
+
+    auto cl_options = options.parse(argc, argv);
+    std::string ruleName = cl_options["rule"].as<std::string>();
+    int rule = slsRule(ruleName);
+    if (rule < 0) {
+        std::cout << "Unknown rule " << ruleName << ", expected probsat or walksat" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+    uint64_t seed = cl_options["seed"].as<uint64_t>();
+    uint64_t maxFlips = cl_options["maxFlips"].as<uint64_t>();
+
+    std::string filename = "sat_problem.cnf";
+    Formula formula;
+    int numVariables = 0;
+
+    // Read the CNF file
+    if (!readDIMACSCNF(filename, formula, numVariables)) {
+        std::cerr << "Failed to read CNF file." << std::endl;
+        return 1;
+    }
+
+    timer t_sls;
+    t_sls.start();
+
+    LocalSearch search(formula, numVariables, seed);
+    if (search.solve(rule, maxFlips)) {
+        Assignment assignment(numVariables);
+        search.model(assignment);
+        std::cout << "SATISFIABLE\n";
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            std::cout << "Variable " << var << " = " << (assignment.value(var) == VALUE_TRUE ? "True" : "False") << "\n";
+        }
+    } else {
+        // Local search is incomplete, running out of flips proves nothing
+        std::cout << "No model found within " << search.flips << " flips\n";
+    }
+    std::cout << "Flips: " << search.flips << "\n";
+
+    double slsTime = t_sls.stop();
+    std::cout << "SLS execution time used : " << slsTime << " seconds" << std::endl;
+
+    return 0;
+}
@@ -4,161 +4,92 @@
 #include <fstream> 
 #include <sstream> // for std::istringstream
 #include "core/get_time.h"
+#include "core/utils.h"
+#include "core/assignment.h"
+#include "core/clause_arena.h"
+#include "core/dimacs.h"
+#include "core/preprocess.h"
+#include "core/propagator.h"
+#include "core/cdcl.h"
 #include <thread>
 #include <atomic>
 
 std::atomic<bool> solutionFound(false);
 
-// Define a Clause as a vector of integers, where each integer represents a variable
-// Positive values denote the variable, and negative values denote its negation.
-typedef std::vector<int> Clause;
-// Define a Formula as a vector of Clauses
-typedef std::vector<Clause> Formula;
+// Clauses removed by preprocessing, to extend the model of the simplified formula
+ReconstructionStack reconstruction;
 
+// A Formula is a flat clause arena: each clause is a run of integers in one shared literal pool,
+// where positive values denote the variable, and negative values denote its negation.
+typedef ClauseArena Formula;
 
-// Function to read a CNF file in DIMACS format and populate the formula
-bool readDIMACSCNF(const std::string& filename, Formula& formula, int& numVariables) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filename << std::endl;
-        return false;
-    }
-
-    std::string line;
-    int numClauses;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == 'c') continue; // Skip comments and empty lines
-        if (line[0] == 'p') {
-            std::istringstream iss(line);
-            std::string tmp;
-            if (!(iss >> tmp >> tmp >> numVariables >> numClauses)) {
-                std::cerr << "Error reading header line: " << line << std::endl;
-                return false;
-            }
-            formula.reserve(numClauses); // Reserve space for clauses
-            continue;
-        }
-        std::istringstream iss(line);
-        Clause clause;
-        int lit;
-        while (iss >> lit && lit != 0) { // Read literals until 0
-            clause.push_back(lit);
-        }
-        if (!clause.empty()) formula.push_back(clause);
-    }
-    return true;
-}
-
-// Function to check if a given assignment of variables satisfies a clause
-bool isClauseSatisfied(const Clause& clause, const std::vector<bool>& assignment, const std::vector<bool>& assigned) {
-    for (int var : clause) {
-        int index = abs(var) - 1; // Convert to 0-based index
-        if (assigned[index]) { // Check if the variable has been assigned
-            bool value = assignment[index]; // Get the assigned value
-            if (var > 0 && value) return true; // Positive literal satisfied
-            if (var < 0 && !value) return true; // Negative literal satisfied
-        }
-    }
-    return false; // None of the literals in the clause are satisfied
-}
-
-bool unitPropagation(Formula &formula, std::vector<bool> &assignment, std::vector<bool> &assigned) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto &clause : formula) {
-            // Count unassigned literals in the clause
-            int unassignedCount = 0;
-            int lastUnassignedLit = 0;
-            for (int lit : clause) {
-                int index = abs(lit) - 1;
-                if (!assigned[index]) {
-                    unassignedCount++;
-                    lastUnassignedLit = lit;
-                } else if ((lit > 0 && assignment[index]) || (lit < 0 && !assignment[index])) {
-                    // Clause already satisfied
-                    unassignedCount = -1;
-                    break;
-                }
-            }
-            if (unassignedCount == 1) {
-                // We have a unit clause, assign the last unassigned literal
-                int index = abs(lastUnassignedLit) - 1;
-                assignment[index] = lastUnassignedLit > 0;
-                assigned[index] = true;
-                changed = true;
-            } else if (unassignedCount == 0) {
-                // Clause cannot be satisfied
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-bool solveSAT(Formula& formula, std::vector<bool>& assignment, std::vector<bool>& assigned, int depth = 0) {
-    // Apply unit propagation to simplify the formula
-    if (!unitPropagation(formula, assignment, assigned)) {
-        // If unitPropagation returns false, the formula is unsatisfiable with the current assignments
-        return false;
-    }
-
-    if (depth == assignment.size()) { // All variables assigned, check if the formula is satisfied
-        // After unit propagation, we might find the formula already satisfied before reaching this depth
-        for (const Clause& clause : formula) {
-            if (!isClauseSatisfied(clause, assignment, assigned)) return false;
-        }
-        return true; // Formula satisfied
-    }
-
-    // Try assigning true to the current variable
-    assigned[depth] = true;
-    assignment[depth] = true;
-    if (solveSAT(formula, assignment, assigned, depth + 1)) return true;
-
-    // Try assigning false to the current variable
-    assignment[depth] = false;
-    if (solveSAT(formula, assignment, assigned, depth + 1)) return true;
-
-    // Backtrack
-    assigned[depth] = false;
-    return false;
-}
 
-bool parallelSolveSAT(Formula& formula, std::vector<bool>& assignment, std::vector<bool>& assigned, int depth = 0, int maxDepthForParallelism = 3) {
+// The assignments handed to the branch threads and returned by them are kept packed. Depth d
+// branches on split[d], the split variables chosen among those left by preprocessing.
+bool parallelSolveSAT(Formula& formula, const std::vector<int>& split, PackedAssignment& assignment, int depth = 0) {
     if(solutionFound.load()) return false; // Check if solution is already found by another thread
     
-    if (depth >= assignment.size() || depth >= maxDepthForParallelism) {
-        // Fallback to sequential execution
-        return solveSAT(formula, assignment, assigned, depth);
+    if (depth >= (int)split.size()) {
+        // Fallback to a sequential restarting CDCL search, with the decisions made so far fixed
+        CDCLSolver solver(formula, assignment.numVariables());
+        solver.stop = &solutionFound;
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            if (assignment.isAssigned(var) && !solver.addUnit(assignment.value(var) == VALUE_TRUE ? var : -var)) return false;
+        }
+        if (!solver.solve()) return false;
+        assignment.pack(solver.engine.assignment);
+        return true;
     }
     
     // Try true in a new thread
-    std::vector<bool> assignmentCopyTrue = assignment;
-    std::vector<bool> assignedCopyTrue = assigned;
-    assignmentCopyTrue[depth] = true;
-    assignedCopyTrue[depth] = true;
+    PackedAssignment assignmentCopyTrue = assignment;
+    assignmentCopyTrue.assign(split[depth], true);
 
+    bool trueResult = false;
     std::thread trueBranch([&, depth]() {
-        if (parallelSolveSAT(formula, assignmentCopyTrue, assignedCopyTrue, depth + 1, maxDepthForParallelism)) {
+        if (parallelSolveSAT(formula, split, assignmentCopyTrue, depth + 1)) {
+            trueResult = true;
             solutionFound.store(true);
         }
     });
 
     // Try false in this thread
-    assignment[depth] = false;
-    assigned[depth] = true;
-    bool falseResult = parallelSolveSAT(formula, assignment, assigned, depth + 1, maxDepthForParallelism);
+    assignment.assign(split[depth], false);
+    bool falseResult = parallelSolveSAT(formula, split, assignment, depth + 1);
 
     // Wait for the true branch to complete
     trueBranch.join();
 
-    return falseResult || solutionFound.load();
+    // Report the model of the true branch if that is the one that succeeded
+    if (!falseResult && trueResult) {
+        assignment = assignmentCopyTrue;
+    }
+
+    return falseResult || trueResult;
 }
 
 
 
-int main() {
+int main(int argc, char *argv[]) {
+
+    cxxopts::Options options(
+        "SAT_divide_conquer",
+        "Solve sat_problem.cnf by splitting on the first variables across threads");
+    options.add_options(
+        "",
+        {
+            {"preprocess", "Comma-separated preprocessing passes (subsume, equiv, probe, bve, bce), or none",
+            cxxopts::value<std::string>()->default_value(DEFAULT_PREPROCESS)},
+        });
+
+    auto cl_options = options.parse(argc, argv);
+    std::string passes = cl_options["preprocess"].as<std::string>();
+    if (!validPreprocess(passes)) {
+        std::cout << "Unknown preprocessing pass in " << passes << ", expected subsume, equiv, probe, bve, bce or none" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+
     std::string filename = "sat_problem.cnf"; 
     Formula formula;
     int numVariables = 0;
@@ -168,17 +99,22 @@ int main() {
         std::cerr << "Failed to read CNF file." << std::endl;
         return 1;
     }
+    preprocess(formula, numVariables, passes, reconstruction);
 
     timer t_serial;
     t_serial.start();
 
-    std::vector<bool> assignment(numVariables, false); // Current assignment of variables
-    std::vector<bool> assigned(numVariables, false); // Track which variables have been assigned
+    PackedAssignment assignment(numVariables); // Current assignment of variables, all unassigned
 
-    if (parallelSolveSAT(formula, assignment, assigned)) {
+    int maxDepthForParallelism = 3;
+    std::vector<int> split = splitVariables(formula, numVariables, maxDepthForParallelism);
+    if (parallelSolveSAT(formula, split, assignment)) {
+        Assignment model;
+        assignment.unpack(model);
+        reconstruction.extend(model);
         std::cout << "SATISFIABLE. Assignment:" << std::endl;
-        for (int i = 0; i < numVariables; ++i) {
-            std::cout << "x" << i + 1 << " = " << (assignment[i] ? "True" : "False") << std::endl;
+        for (int var = 1; var <= numVariables; ++var) {
+            std::cout << "x" << var << " = " << (model.value(var) == VALUE_TRUE ? "True" : "False") << std::endl;
         }
 
         double serialTime = t_serial.stop();
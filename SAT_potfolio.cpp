@@ -4,143 +4,100 @@
 #include <fstream> 
 #include <sstream> // for std::istringstream
 #include "core/get_time.h"
+#include "core/utils.h"
+#include "core/assignment.h"
+#include "core/clause_arena.h"
+#include "core/dimacs.h"
+#include "core/preprocess.h"
+#include "core/propagator.h"
+#include "core/cdcl.h"
+#include "core/restart.h"
+#include "core/sls.h"
 #include <thread>
+#include <atomic>
+#include <mutex>
 
-// Define a Clause as a vector of integers, where each integer represents a variable
-// Positive values denote the variable, and negative values denote its negation.
-typedef std::vector<int> Clause;
-// Define a Formula as a vector of Clauses
-typedef std::vector<Clause> Formula;
+// A Formula is a flat clause arena: each clause is a run of integers in one shared literal pool,
+// where positive values denote the variable, and negative values denote its negation.
+typedef ClauseArena Formula;
 
 std::atomic<bool> found_solution(false);
+std::atomic<bool> sls_stop(false); // Raised once every cube thread is done
 std::mutex io_mutex;
 
-// Function to check if a given assignment of variables satisfies a clause
-bool isClauseSatisfied(const Clause& clause, const std::vector<bool>& assignment, const std::vector<bool>& assigned) {
-    for (int var : clause) {
-        int index = abs(var) - 1; // Convert to 0-based index
-        if (assigned[index]) { // Check if the variable has been assigned
-            bool value = assignment[index]; // Get the assigned value
-            if (var > 0 && value) return true; // Positive literal satisfied
-            if (var < 0 && !value) return true; // Negative literal satisfied
-        }
-    }
-    return false; // None of the literals in the clause are satisfied
-}
-
-bool unitPropagation(Formula &formula, std::vector<bool> &assignment, std::vector<bool> &assigned) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto &clause : formula) {
-            // Count unassigned literals in the clause
-            int unassignedCount = 0;
-            int lastUnassignedLit = 0;
-            for (int lit : clause) {
-                int index = abs(lit) - 1;
-                if (!assigned[index]) {
-                    unassignedCount++;
-                    lastUnassignedLit = lit;
-                } else if ((lit > 0 && assignment[index]) || (lit < 0 && !assignment[index])) {
-                    // Clause already satisfied
-                    unassignedCount = -1;
-                    break;
-                }
-            }
-            if (unassignedCount == 1) {
-                // We have a unit clause, assign the last unassigned literal
-                int index = abs(lastUnassignedLit) - 1;
-                assignment[index] = lastUnassignedLit > 0;
-                assigned[index] = true;
-                changed = true;
-            } else if (unassignedCount == 0) {
-                // Clause cannot be satisfied
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-bool solveSAT(Formula& formula, std::vector<bool>& assignment, std::vector<bool>& assigned, int depth = 0) {
-    // Apply unit propagation to simplify the formula
-    if (!unitPropagation(formula, assignment, assigned)) {
-        // If unitPropagation returns false, the formula is unsatisfiable with the current assignments
-        return false;
-    }
-
-    if (depth == assignment.size()) { // All variables assigned, check if the formula is satisfied
-        // After unit propagation, we might find the formula already satisfied before reaching this depth
-        for (const Clause& clause : formula) {
-            if (!isClauseSatisfied(clause, assignment, assigned)) return false;
-        }
-        return true; // Formula satisfied
-    }
-
-    // Try assigning true to the current variable
-    assigned[depth] = true;
-    assignment[depth] = true;
-    if (solveSAT(formula, assignment, assigned, depth + 1)) return true;
-
-    // Try assigning false to the current variable
-    assignment[depth] = false;
-    if (solveSAT(formula, assignment, assigned, depth + 1)) return true;
-
-    // Backtrack
-    assigned[depth] = false;
-    return false;
-}
-
-void parallelSolveSAT(Formula formula, std::vector<bool> assignment, std::vector<bool> assigned, std::vector<int> decisions) {
-    for (size_t i = 0; i < decisions.size(); ++i) {
-        assigned[i] = true;
-        assignment[i] = decisions[i];
+// Clauses removed by preprocessing, to extend the model of the simplified formula
+ReconstructionStack reconstruction;
+
+// Restart policies handed out round-robin, so the threads do not all share the same tail behaviour
+const char* const restartPolicies[] = {"luby", "ema", "geometric"};
+
+// Solve the formula under the fixed cube literals with a restarting CDCL search, which gives up
+// as soon as another thread has found a solution
+void parallelSolveSAT(const Formula& formula, int numVariables, std::vector<int> cube, std::string restartName,
+                      uint64_t slsInterval, uint64_t slsFlips) {
+    CDCLSolver solver(formula, numVariables, DEFAULT_HEURISTIC, restartName);
+    if (slsInterval > 0) solver.walker.reset(new LocalSearchBursts(formula, numVariables, slsInterval, slsFlips));
+    solver.stop = &found_solution;
+    bool result = true;
+    for (size_t i = 0; result && i < cube.size(); ++i) {
+        result = solver.addUnit(cube[i]);
     }
-    bool result = solveSAT(formula, assignment, assigned, decisions.size());
+    result = result && solver.solve();
     if (result && !found_solution.exchange(true)) { // Check and set found_solution atomically
+        Assignment assignment = solver.engine.assignment;
+        reconstruction.extend(assignment);
         std::lock_guard<std::mutex> lock(io_mutex);
         std::cout << "SATISFIABLE. Assignment:" << std::endl;
-        for (size_t i = 0; i < assignment.size(); ++i) {
-            std::cout << "x" << i + 1 << " = " << (assignment[i] ? "True" : "False") << std::endl;
+        for (int var = 1; var <= assignment.numVariables(); ++var) {
+            std::cout << "x" << var << " = " << (assignment.value(var) == VALUE_TRUE ? "True" : "False") << std::endl;
         }
     }
 }
 
-// Function to read a CNF file in DIMACS format and populate the formula
-bool readDIMACSCNF(const std::string& filename, Formula& formula, int& numVariables) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filename << std::endl;
-        return false;
-    }
-
-    std::string line;
-    int numClauses;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == 'c') continue; // Skip comments and empty lines
-        if (line[0] == 'p') {
-            std::istringstream iss(line);
-            std::string tmp;
-            if (!(iss >> tmp >> tmp >> numVariables >> numClauses)) {
-                std::cerr << "Error reading header line: " << line << std::endl;
-                return false;
-            }
-            formula.reserve(numClauses); // Reserve space for clauses
-            continue;
-        }
-        std::istringstream iss(line);
-        Clause clause;
-        int lit;
-        while (iss >> lit && lit != 0) { // Read literals until 0
-            clause.push_back(lit);
+// Local search over the whole formula next to the cube threads, which often wins on satisfiable
+// random instances. It cannot refute anything, so it runs until the cube threads are done.
+void localSearchSAT(const Formula& formula, int numVariables) {
+    LocalSearch search(formula, numVariables);
+    search.stop = &sls_stop;
+    if (search.solve(SLS_PROBSAT, 0) && !found_solution.exchange(true)) {
+        Assignment assignment(numVariables);
+        search.model(assignment);
+        reconstruction.extend(assignment);
+        std::lock_guard<std::mutex> lock(io_mutex);
+        std::cout << "SATISFIABLE. Assignment:" << std::endl;
+        for (int var = 1; var <= assignment.numVariables(); ++var) {
+            std::cout << "x" << var << " = " << (assignment.value(var) == VALUE_TRUE ? "True" : "False") << std::endl;
         }
-        if (!clause.empty()) formula.push_back(clause);
     }
-    return true;
 }
 
+int main(int argc, char *argv[]) {
+
+    cxxopts::Options options(
+        "SAT_potfolio",
+        "Solve sat_problem.cnf with a portfolio of CDCL cube threads and local search");
+    options.add_options(
+        "",
+        {
+            {"slsInterval", "Conflicts between local search bursts in the CDCL threads, 0 for none",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_SLS_INTERVAL)},
+            {"slsFlips", "Flips per local search burst",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_SLS_FLIPS)},
+            {"preprocess", "Comma-separated preprocessing passes (subsume, equiv, probe, bve, bce), or none",
+            cxxopts::value<std::string>()->default_value(DEFAULT_PREPROCESS)},
+        });
+
+    auto cl_options = options.parse(argc, argv);
+    uint64_t slsInterval = cl_options["slsInterval"].as<uint64_t>();
+    uint64_t slsFlips = cl_options["slsFlips"].as<uint64_t>();
+
+    std::string passes = cl_options["preprocess"].as<std::string>();
+    if (!validPreprocess(passes)) {
+        std::cout << "Unknown preprocessing pass in " << passes << ", expected subsume, equiv, probe, bve, bce or none" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
 
-int main() {
     std::string filename = "sat_problem.cnf"; 
     Formula formula;
     int numVariables = 0;
@@ -150,9 +107,7 @@ int main() {
         std::cerr << "Failed to read CNF file." << std::endl;
         return 1;
     }
-
-    std::vector<bool> assignment(numVariables, false); // Current assignment of variables
-    std::vector<bool> assigned(numVariables, false); // Track which variables have been assigned
+    preprocess(formula, numVariables, passes, reconstruction);
 
     timer t;
     t.start();
@@ -160,19 +115,23 @@ int main() {
     int parallelDepth = 3; // Number of variables to explore in parallel
     std::vector<std::thread> threads;
 
-    // Creating 4 threads based on binary decisions for the first two variables
-    for (int i = 0; i < (1 << parallelDepth); ++i) { // 1 << parallelDepth = 2^parallelDepth
-        std::vector<int> decisions(parallelDepth);
-        for (int j = 0; j < parallelDepth; ++j) {
-            decisions[j] = (i & (1 << j)) != 0; // Determine the truth value for each decision
+    // One thread per cube over the split variables, which preprocessing may have left fewer of
+    std::vector<int> split = splitVariables(formula, numVariables, parallelDepth);
+    for (int i = 0; i < (1 << split.size()); ++i) { // 1 << split.size() = 2^split.size()
+        std::vector<int> cube(split.size());
+        for (size_t j = 0; j < split.size(); ++j) {
+            cube[j] = (i & (1 << j)) != 0 ? split[j] : -split[j]; // Determine the truth value for each decision
         }
-        threads.emplace_back(parallelSolveSAT, formula, assignment, assigned, decisions);
+        threads.emplace_back(parallelSolveSAT, std::cref(formula), numVariables, cube, restartPolicies[i % 3], slsInterval, slsFlips);
     }
+    std::thread localSearch(localSearchSAT, std::cref(formula), numVariables);
 
     // Join all threads
     for (auto& thread : threads) {
         thread.join();
     }
+    sls_stop.store(true);
+    localSearch.join();
 
     if (!found_solution) {
         std::cout << "UNSATISFIABLE." << std::endl;
@@ -5,6 +5,17 @@
 #include <sstream> // for std::istringstream
 #include "core/get_time.h"
 #include "core/utils.h"
+#include "core/assignment.h"
+#include "core/clause_arena.h"
+#include "core/dimacs.h"
+#include "core/preprocess.h"
+#include "core/propagator.h"
+#include "core/dpll.h"
+#include "core/occurrences.h"
+#include "core/task_pool.h"
+#include "core/cdcl.h"
+#include "core/restart.h"
+#include "core/sls.h"
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -14,6 +25,7 @@
 #include <condition_variable>
 #include <queue>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -27,54 +39,78 @@
 
 uint n_threads = 1;
 
-// Define a Clause as a vector of integers, where each integer represents a variable
-// Positive values denote the variable, and negative values denote its negation.
-typedef std::vector<int> Clause;
-// Define a Formula as a vector of Clauses
-typedef std::vector<Clause> Formula;
+#define DEFAULT_MODE "dpll"
+
+// A Formula is a flat clause arena: each clause is a run of integers in one shared literal pool,
+// where positive values denote the variable, and negative values denote its negation.
+typedef ClauseArena Formula;
 
 std::atomic<bool> found_solution{false};
 std::atomic<bool> all_workers_should_stop{false};
 
-struct Task {
-    Formula formula;
-    std::map<int, std::optional<bool>> assignment;
+// Clauses removed by preprocessing, to extend the model of the simplified formula
+ReconstructionStack reconstruction;
 
-    Task(Formula f, std::map<int, std::optional<bool>> a)
-        : formula(f), assignment(a) {}
+// A task is a subtree of the search, identified by the guiding path leading to it.
+// Tasks live in per-worker pools and are passed around by move-only handles.
+struct Task {
+    GuidingPath path;
 };
 
 class TaskQueue {
-    std::queue<std::shared_ptr<Task>> queue;
+    std::queue<TaskHandle<Task>> queue;
     std::mutex mutex;
     std::condition_variable cond;
+    std::atomic<int> idle_workers{0};  // Workers blocked in getTask
+    std::atomic<size_t> queued{0};     // Tasks waiting in the queue
+    int outstanding = 0;               // Tasks queued or being explored, guarded by mutex
 
 
 public:
     std::vector<int> completed_task;
     TaskQueue(uint n_thread): completed_task(n_thread){}
 
-    void addTask(const std::shared_ptr<Task>& task) {
+    void addTask(TaskHandle<Task> task) {
         std::lock_guard<std::mutex> lock(mutex);
-        queue.push(task);
+        queue.push(std::move(task));
+        queued++;
+        outstanding++;
         cond.notify_all();
     }
 
-    std::shared_ptr<Task> getTask() {
+    // A worker is done exploring a task. Tasks split off it were added before, so once nothing is
+    // outstanding every subtree has been refuted and the workers are released.
+    void finishTask() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--outstanding == 0) {
+            all_workers_should_stop.store(true);
+            cond.notify_all();
+        }
+    }
+
+    TaskHandle<Task> getTask() {
         std::unique_lock<std::mutex> lock(mutex);
         // Wait until there is a task or it's time to stop all workers
+        idle_workers++;
         cond.wait(lock, [this] { return !queue.empty() || all_workers_should_stop.load(); });
+        idle_workers--;
         if (all_workers_should_stop.load()) {
-            return nullptr; // Return nullptr if it's time to stop to ensure no thread is left waiting
+            return TaskHandle<Task>(); // Return an empty handle if it's time to stop to ensure no thread is left waiting
         }
         if (!queue.empty()) {
-            auto task = queue.front();
+            TaskHandle<Task> task = std::move(queue.front());
             queue.pop();
+            queued--;
             return task;
         }
-        return nullptr;
+        return TaskHandle<Task>();
     }
     
+    // Some worker is waiting and nothing is queued for it, so busy workers should split off work
+    bool needsWork() {
+        return idle_workers.load(std::memory_order_relaxed) > 0 && queued.load(std::memory_order_relaxed) == 0;
+    }
+
     bool isEmpty() {
         std::lock_guard<std::mutex> lock(mutex);
         return queue.empty();
@@ -89,316 +125,252 @@ public:
 
 
 
-// Function to read a CNF file in DIMACS format and populate the formula
-bool readDIMACSCNF(const std::string& filename, Formula& formula, int& numVariables) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filename << std::endl;
-        return false;
-    }
-
-    std::string line;
-    int numClauses;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == 'c') continue; // Skip comments and empty lines
-        if (line[0] == 'p') {
-            std::istringstream iss(line);
-            std::string tmp;
-            if (!(iss >> tmp >> tmp >> numVariables >> numClauses)) {
-                std::cerr << "Error reading header line: " << line << std::endl;
-                return false;
-            }
-            formula.reserve(numClauses); // Reserve space for clauses
-            continue;
-        }
-        std::istringstream iss(line);
-        Clause clause;
-        int lit;
-        while (iss >> lit && lit != 0) { // Read literals until 0
-            clause.push_back(lit);
-        }
-        if (!clause.empty()) formula.push_back(clause);
-    }
-    return true;
-}
-
-// Helper function to get unassigned keys from the assignment map
-std::set<int> getUnassignedKeys(const std::map<int, std::optional<bool>>& assignment) {
-    std::set<int> keys;
-    
-    // Iterate over the map and check for keys with a std::nullopt value
-    for (const auto& [key, val] : assignment) {
-        if (!val.has_value()) {  // Equivalent to checking if val is std::nullopt
-            keys.insert(key);
-        }
-    }
-    // Sort the keys
-    // std::sort(keys.begin(), keys.end());
-
-    return keys;
-}
-
 // Simplify the formula based on the current assignments
-Formula simplifyFormula(const Formula& formula, 
-                        std::map<int, std::optional<bool>>& assignment) {
-    Formula newFormula;
-
-    for (const auto& clause : formula) {
-        bool satisfied = false;
-        for (int lit : clause) {
-            if (lit > 0) {
-                if (assignment.count(lit) && assignment[lit] == std::optional<bool>(true)) {
-                    satisfied = true;
-                    break;
-                }
-            } else {
-                if (assignment.count(std::abs(lit)) && assignment[std::abs(lit)] == std::optional<bool>(false)) {
-                    satisfied = true;
-                    break;
-                }
-            }
-        }
-        if (!satisfied) {
-            newFormula.push_back(clause);
-        }
-    }
-
-    auto unassignedKeys = getUnassignedKeys(assignment);
-
-    // Push all lit in the new Formula to keyInFormula
-    std::vector<int> keyInFormula;
-    for (const auto& clause : newFormula) {
-        for (int lit : clause) {
-            // If lit not already in keyInFormula, then push it in
-            if (std::find(keyInFormula.begin(), keyInFormula.end(), lit) == keyInFormula.end()) {
-                keyInFormula.push_back(lit);
-            }
-        }
-    }
-
-    // For each unassigned lit if its potive lit and negative lit all NOT found in varInFormula then set it to true (as we don't need it)
-    for (int key : unassignedKeys) {
-        if (std::find(keyInFormula.begin(), keyInFormula.end(), key) == keyInFormula.end() &&
-            std::find(keyInFormula.begin(), keyInFormula.end(), -key) == keyInFormula.end()) {
-            assignment[std::abs(key)] = std::optional<bool>(true);
+// The literals assigned since the last node update the satisfied-clause and live-occurrence counters
+// through their occurrence lists; unassigned variables left in no unsatisfied clause are set to true
+void simplifyFormula(DPLLSearch& search) {
+    ClauseState& live = search.live;
+    const Assignment& assignment = search.engine.assignment;
+    live.sync(search.engine.trail);
+
+    // For each candidate lit if its potive lit and negative lit are both gone from the unsatisfied clauses then set it to true (as we don't need it)
+    for (int var : live.candidates) {
+        if (!assignment.isAssigned(var) && live.liveCount(var) == 0 && live.liveCount(-var) == 0) {
+            search.engine.enqueue(var);
         }
     }
-
-    return newFormula;
 }
 
 
 // See if by assigning clauses with only one missing value can satisfy, return true if unit clause is satisfiable
-bool unitPropagation(Formula& formula, std::map<int, std::optional<bool>>& assignment) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto& clause : formula) {
-            int unassignedCount = 0;
-            int lastUnassignedLit = 0;
-            for (int lit : clause) {
-                // Count the unassigned lit number in the clause 
-                if (!assignment[std::abs(lit)].has_value()) {
-                    unassignedCount++;
-                    lastUnassignedLit = lit;
-                } 
-                // Else see if the clause satisfy, if statisfied set count to -1
-                else if ((lit > 0 && assignment[std::abs(lit)] == true) ||
-                           (lit < 0 && assignment[std::abs(lit)] == false)) {
-                    unassignedCount = -1; // Clause is already satisfied, to next clause
-                    break;
-                }
-            }
-            // If only 1 unassigned lit in the clause, assign the value
-            if (unassignedCount == 1) { // This is a unit clause
-                assignment[std::abs(lastUnassignedLit)] = (lastUnassignedLit > 0);
-                changed = true;
-            } 
-            // Else if clause cannot be satisfied
-            else if (unassignedCount == 0) {
-                // std::cout << "Dead end" << "\n";
-                return false; // Clause cannot be satisfied, then means this path FAILS
-            }
-        }
+// Only the clauses watching a literal that just became false are visited.
+bool unitPropagation(DPLLSearch& search) {
+    ClauseRef confl = search.engine.propagate();
+    if (confl != CLAUSE_REF_UNDEF) {
+        search.conflict(confl);
+        return false; // Clause cannot be satisfied, then means this path FAILS
     }
     return true;
 }
 
-void pureLiteralElimination(Formula& formula, std::map<int, std::optional<bool>>& assignment) {
-    // std::map<int, int> polarity;
-    // for (auto& clause : formula) {
-    //     for (int lit : clause) {
-    //         if (!assignment[std::abs(lit)].has_value()) {
-    //             polarity[lit]++;
-    //         }
-    //     }
-    // }
-
-    // for (auto& p : polarity) {
-    //     if (polarity[-p.first] == 0 && p.second != 0) { // Pure literal found
-    //         assignment[std::abs(p.first)] = (p.first > 0);
-    //     }
-    // }
-
-
-    std::map<int, int> polarity;
-    std::set<int> consideredLiterals = getUnassignedKeys(assignment);
-    for (auto& clause : formula) {
-        for (int lit : clause) {
-            int abs_lit = std::abs(lit);
-            if (!assignment[abs_lit].has_value() && consideredLiterals.find(abs_lit) != consideredLiterals.end()) {
-                polarity[lit]++;
-                // consideredLiterals.insert(abs_lit);
-            }
-        }
-    }
-
-    // Test
-    // for (auto& p : polarity) {
-    //     // if (polarity[-p.first] == 0 && p.second != 0) { // Pure literal found
-    //     //     assignment[std::abs(p.first)] = (p.first > 0);
-    //     // }
-    //     std::cout << p.first << "|" << p.second << "\n";
-    // }
-
-    for (int lit : consideredLiterals) {
-        if (polarity[lit] > 0 && polarity[-lit] == 0) {  // Only positive literals are present
-            assignment[std::abs(lit)] = true;
-        } else if (polarity[-lit] > 0 && polarity[lit] == 0) {  // Only negative literals are present
-            assignment[std::abs(lit)] = false;
+// Pure literals are looked for only among the candidate variables whose live occurrences just changed
+void pureLiteralElimination(DPLLSearch& search) {
+    ClauseState& live = search.live;
+    const Assignment& assignment = search.engine.assignment;
+    live.sync(search.engine.trail);
+
+    for (int var : live.candidates) {
+        if (assignment.isAssigned(var)) continue;
+        if (live.liveCount(var) > 0 && live.liveCount(-var) == 0) {  // Only positive literals are present
+            search.engine.enqueue(var);
+        } else if (live.liveCount(-var) > 0 && live.liveCount(var) == 0) {  // Only negative literals are present
+            search.engine.enqueue(-var);
         }
     }
+    live.candidates.clear();
 }
 
-bool isFormulaSatisfied(const Formula& formula, const std::map<int, std::optional<bool>>& assignment) {
-    for (const auto& clause : formula) {
-        bool satisfied = false;
-        for (int lit : clause) {
-            if ((lit > 0 && assignment.at(std::abs(lit)) == true) ||
-                (lit < 0 && assignment.at(std::abs(lit)) == false)) {
-                satisfied = true;
-                break;
-            }
-        }
-        if (!satisfied) return false;
-    }
-    return true;
+// The formula is satisfied once every clause counts a true literal
+bool isFormulaSatisfied(DPLLSearch& search) {
+    search.live.sync(search.engine.trail);
+    return search.live.allSatisfied();
 }
 
-void makeDecisionAndSpawn(std::shared_ptr<Task> task, TaskQueue& taskQueue) {
-    // Find the first unassigned variable
-    int variable = -1;
-    for (const auto& [var, val] : task->assignment) {
-        if (!val.has_value()) {
-            variable = var;
-            break;
+// Branch on the variable picked by the decision heuristic, and hand the open branch closest to the root to an idle
+// worker if one is waiting. Returns false if there is no variable left to branch on.
+bool makeDecisionAndSpawn(DPLLSearch& search, TaskQueue& taskQueue, TaskPool<Task>& pool) {
+    if (taskQueue.needsWork()) {
+        TaskHandle<Task> child = pool.acquire();
+        if (search.split(child->path)) {
+            taskQueue.addTask(std::move(child));
         }
     }
 
-    if (variable != -1) {
-        // Create two new nodes for each possible value of the variable
-        for (bool val : {true, false}) {
-            std::map<int, std::optional<bool>> newAssignment = task->assignment;
-            newAssignment[variable] = val;
-
-            Formula newFormula = task->formula; // Copy formula to potentially simplify
-            // if (!unitPropagation(newFormula, newAssignment)) continue; // Skip unsatisfiable path
+    // Ask the heuristic for an unassigned variable
+    const Assignment& assignment = search.engine.assignment;
+    int variable = search.heuristic->pickBranchVariable(assignment);
+    if (variable == 0) return false;
 
-            std::shared_ptr<Task> newNode = std::make_shared<Task>(newFormula, newAssignment);
-            taskQueue.addTask(newNode);
-        }
-    } 
-    // If no available variable found
-    // else {
-    //     // All variables are assigned, check if the formula is satisfied
-    //     std::cout << "Dead end" << "\n";
-    // }
-    return;
+    // Explore the preferred polarity in place, the other branch stays open on the trail
+    search.decide(search.branchLiteral(variable));
+    return true;
 }
 
-uint countAssigned(const std::map<int, std::optional<bool>>& assignment){
-    uint count = 0;
-    for (const auto& [key, val] : assignment) {
-        if (val.has_value()) {  // Equivalent to checking if val is std::nullopt
-            count++;
-        }
-    }
-    return count;
-}
+void worker(TaskQueue& taskQueue, TaskPool<Task>& pool, uint thread_id, uint n_threads, std::shared_ptr<const Formula> rootFormula, std::shared_ptr<const OccurrenceLists> occurrences, int numVariables, std::string heuristicName, uint64_t slsInterval, uint64_t slsFlips) {
+    // Each worker explores its subtrees in place on its own trail over the original formula
+    DPLLSearch search(rootFormula, occurrences, numVariables, heuristicName);
+    const Assignment& assignment = search.engine.assignment;
+    pool.adopt();
+
+    // Optional local search bursts that steer the decision phases
+    std::unique_ptr<LocalSearchBursts> walker;
+    if (slsInterval > 0) walker.reset(new LocalSearchBursts(*rootFormula, numVariables, slsInterval, slsFlips));
+    uint64_t conflicts = 0;
 
-void worker(TaskQueue& taskQueue, uint thread_id, uint n_threads) {
     while (!all_workers_should_stop.load()) {
-        auto node = taskQueue.getTask();
+        TaskHandle<Task> task = taskQueue.getTask();
         // Wait for task
-        if (node == nullptr || found_solution.load()) {
+        if (!task || found_solution.load()) {
             break; // Exit if no task or solution found
         }
-        // Count the task given
-        taskQueue.completed_task[thread_id]++;
 
-        if (taskQueue.completed_task[thread_id] % 1000 == 0){
-            std::cout << "Thread number  " << thread_id << ", numOfTask: "  << taskQueue.completed_task[thread_id] << "\n";
-            std::cout << "Assigned number:  " << countAssigned(node->assignment) << "\n";
-        }
+        // Explore the subtree of the task node by node, a failed node moves on to the next open branch
+        bool open = search.start(task->path);
+        while (open && !all_workers_should_stop.load()) {
+            // Count the node visited
+            taskQueue.completed_task[thread_id]++;
 
-        // std::cout << "START\n";
-        // for (const auto& [var, val] : node->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
-
-        // PROCESS THE TASK
-        // If the current assignment does not satisfy, then skip
-        if (!unitPropagation(node->formula, node->assignment)) continue;
-
-        // std::cout << "AFTER UNITPROP\n";
-        // for (const auto& [var, val] : node->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
-
-        // Simplfy the form
-        node->formula = simplifyFormula(node->formula, node->assignment);
-
-        // Liminate all pure literal
-        pureLiteralElimination(node->formula, node->assignment);
-
-        // std::cout << "AFTER PUREELIM\n";
-        // for (const auto& [var, val] : node->assignment) {
-        //     if (val.has_value()) {
-        //         std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
-        //     }
-        // }
-
-        // Simplfy the form
-        node->formula = simplifyFormula(node->formula, node->assignment);
-
-        if (isFormulaSatisfied(node->formula, node->assignment)) {
-            found_solution.store(true);
-            all_workers_should_stop.store(true);
-            taskQueue.notifyAllWorkers();  // notify all threads
-            std::cout << "SATISFIABLE\n";
-            for (const auto& [var, val] : node->assignment) {
-                if (val.has_value()) {
-                    std::cout << "Variable " << var << " = " << (val.value() ? "True" : "False") << "\n";
+            if (taskQueue.completed_task[thread_id] % 1000 == 0){
+                std::cout << "Thread number  " << thread_id << ", numOfTask: "  << taskQueue.completed_task[thread_id] << "\n";
+                std::cout << "Assigned number:  " << search.engine.trail.size() << "\n";
+            }
+
+            // PROCESS THE NODE
+            // If the current assignment does not satisfy, then backtrack
+            if (!unitPropagation(search)) {
+                conflicts++;
+                // Without learning a restart would throw the subtree away, so the best assignment of the
+                // burst only sets the phases of the variables decided from now on
+                if (walker && walker->due(conflicts)) {
+                    walker->run(assignment.values, conflicts);
+                    walker->savePhases(search.phases.saved);
+                }
+                open = search.backtrack();
+                continue;
+            }
+
+            // Simplfy the form
+            simplifyFormula(search);
+
+            // Liminate all pure literal
+            pureLiteralElimination(search);
+
+            // Simplfy the form
+            simplifyFormula(search);
+
+            if (isFormulaSatisfied(search)) {
+                found_solution.store(true);
+                all_workers_should_stop.store(true);
+                taskQueue.notifyAllWorkers();  // notify all threads
+                // Give the variables removed by preprocessing their values back
+                Assignment model = assignment;
+                reconstruction.extend(model);
+                std::cout << "SATISFIABLE\n";
+                for (int var = 1; var <= model.numVariables(); var++) {
+                    std::cout << "Variable " << var << " = " << (model.value(var) == VALUE_TRUE ? "True" : "False") << "\n";
                 }
+                // Stats
+                for (uint i = 0; i < n_threads; i++){
+                    std::cout << "Thread number " << i << " finished " << taskQueue.completed_task[i] << " tasks." << "\n";
+                }
+                break;
             }
-            // Stats
-            for (uint i = 0; i < n_threads; i++){
-                std::cout << "Thread number " << i << " finished " << taskQueue.completed_task[i] << " tasks." << "\n";
+
+            if (!makeDecisionAndSpawn(search, taskQueue, pool)) {
+                open = search.backtrack();
             }
-            break;
         }
-        
-        makeDecisionAndSpawn(node, taskQueue);
+        taskQueue.finishTask();
     }
     // std::cout << thread_id << std::endl;
 }
 
+// Solve the formula with conflict-driven clause learning instead of the DPLL worker
+void solveCDCL(const Formula& formula, int numVariables, const std::string& heuristicName, const std::string& restartName,
+               uint64_t slsInterval, uint64_t slsFlips) {
+    CDCLSolver solver(formula, numVariables, heuristicName, restartName);
+    if (slsInterval > 0) solver.walker.reset(new LocalSearchBursts(formula, numVariables, slsInterval, slsFlips));
+    if (solver.solve()) {
+        Assignment model = solver.engine.assignment;
+        reconstruction.extend(model);
+        std::cout << "SATISFIABLE\n";
+        for (int var = 1; var <= model.numVariables(); var++) {
+            std::cout << "Variable " << var << " = " << (model.value(var) == VALUE_TRUE ? "True" : "False") << "\n";
+        }
+    } else {
+        std::cout << "UNSATISFIABLE\n";
+    }
+    std::cout << "Conflicts: " << solver.conflicts << ", decisions: " << solver.decisions << ", restarts: " << solver.restarts
+              << ", propagations: " << solver.engine.propagations << "\n";
+    std::cout << "Learned literals: " << solver.learnedLiterals << ", removed by minimization: " << solver.minimizedLiterals
+              << ", antecedents strengthened: " << solver.strengthened
+              << ", chronological backtracks: " << solver.chronoBacktracks << "\n";
+    std::cout << "Learned clauses subsumed: " << solver.subsumedLearned
+              << ", literals removed by self-subsumption: " << solver.strengthenedLearned << "\n";
+    const LearnedClauseDB& db = solver.db;
+    std::cout << "Learned clauses kept: core " << db.tierSize[TIER_CORE] << ", tier2 " << db.tierSize[TIER_MID]
+              << ", local " << db.tierSize[TIER_LOCAL] << "; reductions: " << db.reductions
+              << ", deleted: " << db.deleted << ", reduction time: " << db.reduceTime << " seconds\n";
+    if (solver.walker) {
+        std::cout << "Local search bursts: " << solver.walker->bursts << ", ending on a model: " << solver.walker->models
+                  << ", flips: " << solver.walker->search.flips << "\n";
+    }
+}
+
 int main(int argc, char *argv[]) {
 
+    cxxopts::Options options(
+        "SAT_serial",
+        "Solve sat_problem.cnf with a single worker");
+    options.add_options(
+        "",
+        {
+            {"mode", "Search algorithm, dpll or cdcl",
+            cxxopts::value<std::string>()->default_value(DEFAULT_MODE)},
+            {"heuristic", "Decision heuristic, order, vsids, jw or moms (jw and moms with dpll only)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_HEURISTIC)},
+            {"preprocess", "Comma-separated preprocessing passes (subsume, equiv, probe, bve, bce), or none",
+            cxxopts::value<std::string>()->default_value(DEFAULT_PREPROCESS)},
+            {"restart", "Restart policy, none, luby, geometric or ema (cdcl only, default luby)",
+            cxxopts::value<std::string>()->default_value("")},
+            {"slsInterval", "Conflicts between local search bursts, 0 for none",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_SLS_INTERVAL)},
+            {"slsFlips", "Flips per local search burst",
+            cxxopts::value<uint64_t>()->default_value(DEFAULT_SLS_FLIPS)},
+        });
+
+    auto cl_options = options.parse(argc, argv);
+    std::string mode = cl_options["mode"].as<std::string>();
+    if (mode != "dpll" && mode != "cdcl") {
+        std::cout << "Unknown mode " << mode << ", expected dpll or cdcl" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+    std::string heuristicName = cl_options["heuristic"].as<std::string>();
+    if (!makeHeuristic(heuristicName, 0)) {
+        std::cout << "Unknown heuristic " << heuristicName << ", expected order, vsids, jw or moms" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+    if (mode == "cdcl" && makeHeuristic(heuristicName, 0)->usesClauseScores()) {
+        std::cout << "Heuristic " << heuristicName << " scores the clauses of the DPLL search, use it with --mode dpll" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+    // DPLL learns nothing, so a restart would only explore the closed branches again
+    std::string restartName = cl_options["restart"].as<std::string>();
+    if (restartName.empty()) restartName = mode == "cdcl" ? DEFAULT_RESTART : "none";
+    if (!makeRestartPolicy(restartName)) {
+        std::cout << "Unknown restart policy " << restartName << ", expected none, luby, geometric or ema" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+    if (mode == "dpll" && restartName != "none") {
+        std::cout << "Restart policy " << restartName << " needs the learned clauses of --mode cdcl" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+
+    uint64_t slsInterval = cl_options["slsInterval"].as<uint64_t>();
+    uint64_t slsFlips = cl_options["slsFlips"].as<uint64_t>();
+
+    std::string passes = cl_options["preprocess"].as<std::string>();
+    if (!validPreprocess(passes)) {
+        std::cout << "Unknown preprocessing pass in " << passes << ", expected subsume, equiv, probe, bve, bce or none" << std::endl;
+        std::cout << "Exiting." << std::endl;
+        return -1;
+    }
+
     std::string filename = "sat_problem.cnf"; 
     Formula formula;
     int numVariables = 0;
@@ -408,31 +380,46 @@ int main(int argc, char *argv[]) {
         std::cerr << "Failed to read CNF file." << std::endl;
         return 1;
     }
+    preprocess(formula, numVariables, passes, reconstruction);
+
+    // The simplified formula is read-only from now on, every worker shares it
+    std::shared_ptr<const Formula> rootFormula = std::make_shared<const Formula>(std::move(formula));
+    std::shared_ptr<const OccurrenceLists> occurrences = std::make_shared<const OccurrenceLists>(*rootFormula, numVariables);
 
     timer t_serial;
     t_serial.start();
 
-    std::map<int, std::optional<bool>> initial_assignment;
-
-    // Initialize the map with keys from 1 to numVariables, all values set to std::nullopt
-    for (int i = 1; i <= numVariables; ++i) {
-        initial_assignment[i] = std::nullopt;
+    if (mode == "cdcl") {
+        solveCDCL(*rootFormula, numVariables, heuristicName, restartName, slsInterval, slsFlips);
+        double serialTime = t_serial.stop();
+        std::cout << "Serial execution time used : " << serialTime << " seconds"<< std::endl;
+        return 0;
     }
 
-    std::shared_ptr<Task> root = std::make_shared<Task>(formula, initial_assignment);
+    // One task pool per worker, declared before the queue so it outlives every queued task
+    std::vector<TaskPool<Task>> pools(n_threads);
+
+    // The root task is the whole search tree, with an empty guiding path
+    TaskHandle<Task> root = pools[0].acquire();
+    root->path.clear();
     TaskQueue taskQueue(n_threads);
-    taskQueue.addTask(root);
+    taskQueue.addTask(std::move(root));
 
     // Start worker threads
     std::vector<std::thread> workers;
     for (int i = 0; i < n_threads; ++i) {
-        workers.emplace_back(worker, std::ref(taskQueue), i, n_threads);
+        workers.emplace_back(worker, std::ref(taskQueue), std::ref(pools[i]), i, n_threads, rootFormula, occurrences, numVariables, heuristicName, slsInterval, slsFlips);
     }
     // Join threads
     for (auto& t : workers) {
         t.join();  
     }
 
+    // Every worker stopped without a model, so every subtree was refuted
+    if (!found_solution.load()) {
+        std::cout << "UNSATISFIABLE\n";
+    }
+
     double serialTime = t_serial.stop();
 
     std::cout << "Serial execution time used : " << serialTime << " seconds"<< std::endl;
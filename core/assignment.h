@@ -0,0 +1,107 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <cstdint>
+#include <vector>
+
+// Literals follow the DIMACS convention: variable v appears as v, its negation as -v.
+// Variables are numbered from 1, so slot 0 of every variable-indexed table is unused.
+#define VALUE_UNASSIGNED 0
+#define VALUE_TRUE 1
+#define VALUE_FALSE -1
+
+// Variable of a literal
+inline int litVar(int lit) { return lit > 0 ? lit : -lit; }
+
+// Dense index of a literal (2v for v, 2v+1 for -v) for per-literal tables
+inline uint32_t litIndex(int lit) { return lit > 0 ? 2u * lit : 2u * (-lit) + 1u; }
+
+// Inverse of litIndex
+inline int indexLit(uint32_t index) { return (index & 1u) ? -(int)(index >> 1) : (int)(index >> 1); }
+
+// Variable-indexed value array, one int8 per variable holding VALUE_UNASSIGNED / VALUE_TRUE / VALUE_FALSE.
+// Reading the value of a literal is a single load plus a sign flip.
+struct Assignment {
+    std::vector<int8_t> values;
+
+    Assignment() = default;
+    explicit Assignment(int numVariables) : values(numVariables + 1, VALUE_UNASSIGNED) {}
+
+    int numVariables() const { return (int)values.size() - 1; }
+
+    int8_t value(int var) const { return values[var]; }
+
+    bool isAssigned(int var) const { return values[var] != VALUE_UNASSIGNED; }
+
+    // VALUE_TRUE if the literal is satisfied, VALUE_FALSE if falsified, VALUE_UNASSIGNED otherwise
+    int8_t litValue(int lit) const {
+        int8_t val = values[litVar(lit)];
+        return lit > 0 ? val : -val;
+    }
+
+    void assign(int var, bool val) { values[var] = val ? VALUE_TRUE : VALUE_FALSE; }
+
+    // Make the literal true
+    void assignLit(int lit) { values[litVar(lit)] = lit > 0 ? VALUE_TRUE : VALUE_FALSE; }
+
+    void unassign(int var) { values[var] = VALUE_UNASSIGNED; }
+};
+
+// Assignment packed two bits per variable (01 true, 10 false, 00 unassigned), 32 variables per word.
+// Used whenever a partial assignment is stored or sent to another process: 1000 variables take 256
+// bytes, and since an assigned variable has exactly one bit set, counting them is a popcount per word.
+struct PackedAssignment {
+    int n;
+    std::vector<uint64_t> words;
+
+    PackedAssignment() : n(0) {}
+    explicit PackedAssignment(int numVariables) : n(numVariables), words(numWords(numVariables), 0) {}
+    explicit PackedAssignment(const Assignment& assignment) { pack(assignment); }
+
+    static size_t numWords(int numVariables) { return ((size_t)numVariables + 32) / 32; }
+
+    int numVariables() const { return n; }
+
+    uint64_t bits(int var) const { return (words[var >> 5] >> ((var & 31) * 2)) & 3u; }
+
+    // VALUE_TRUE, VALUE_FALSE or VALUE_UNASSIGNED, decoded as (low bit) - (high bit)
+    int8_t value(int var) const {
+        uint64_t b = bits(var);
+        return (int8_t)((int)(b & 1u) - (int)(b >> 1));
+    }
+
+    bool isAssigned(int var) const { return bits(var) != 0; }
+
+    void assign(int var, bool val) {
+        uint64_t shift = (var & 31) * 2;
+        uint64_t& word = words[var >> 5];
+        word = (word & ~(3ull << shift)) | ((val ? 1ull : 2ull) << shift);
+    }
+
+    void unassign(int var) { words[var >> 5] &= ~(3ull << ((var & 31) * 2)); }
+
+    void pack(const Assignment& assignment) {
+        n = assignment.numVariables();
+        words.assign(numWords(n), 0);
+        const int8_t* values = assignment.values.data();
+        for (int var = 1; var <= n; var++) {
+            uint64_t code = (uint64_t)(values[var] > 0) | ((uint64_t)(values[var] < 0) << 1);
+            words[var >> 5] |= code << ((var & 31) * 2);
+        }
+    }
+
+    void unpack(Assignment& assignment) const {
+        assignment.values.assign(n + 1, VALUE_UNASSIGNED);
+        for (int var = 1; var <= n; var++) {
+            assignment.values[var] = value(var);
+        }
+    }
+
+    int countAssigned() const {
+        int count = 0;
+        for (uint64_t word : words) count += __builtin_popcountll(word);
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,463 @@
+#ifndef CDCL_H
+#define CDCL_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include "propagator.h"
+#include "heuristics.h"
+#include "restart.h"
+#include "phase.h"
+#include "clause_db.h"
+#include "sls.h"
+#include "subsume.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CHRONO_DISTANCE 100        // Backjumps over more levels than this backtrack chronologically instead
+#define CHRONO_MIN_CONFLICTS 4000  // Conflicts before chronological backtracking is first used
+#define SUBSUME_INTERVAL 5000      // Conflicts between two subsumption rounds over the learned clauses
+
+// Conflict-driven clause learning on top of the propagation engine.
+// A conflict is traced back through the reasons of the implied literals to the first unique
+// implication point of the current level, the resulting clause is learned, and the search jumps
+// back to the second highest level in it, where the clause immediately asserts its UIP literal.
+// The restart policy periodically drops the search back to level 0, keeping the learned clauses,
+// and the learned clause database periodically throws the least useful of them away.
+// Learned clauses are shrunk by recursive minimization, and the antecedents met during analysis are
+// strengthened on the fly when the resolvent shows that their implied literal is redundant.
+// A backjump that would undo many levels only backtracks one level below the conflict instead, keeping
+// the propagated literals of the levels in between (chronological backtracking, Nadel and Ryvchin 2018),
+// so long trails are not rebuilt by propagating them again.
+// Every few thousand conflicts a restart also runs subsumption over the learned clauses: those subsumed
+// by another clause are deleted, and those subsumed with one literal negated lose that literal.
+class CDCLSolver {
+public:
+    Propagator engine;
+    std::vector<char> seen;   // Per variable, marked during conflict analysis
+    std::vector<int> learnt;  // Clause being learned, asserting literal first
+    std::vector<int> analyzeStack;      // Scratch for recursive minimization
+    std::vector<int> analyzeToClear;    // Literals marked seen by minimization
+    std::vector<std::pair<ClauseRef, int>> strengthen; // Antecedents found redundant in their implied literal
+    int chronoDistance;               // Jump distance above which to backtrack chronologically, 0 to always backjump
+    uint64_t chronoMinConflicts;      // Conflicts before chronological backtracking is first used
+    uint64_t subsumeInterval;         // Conflicts between subsumption rounds, 0 to never run them
+    uint64_t nextSubsume;
+    std::vector<std::vector<ClauseRef>> learnedOccurs; // Scratch for subsumption, indexed by litIndex
+    std::vector<uint64_t> signatures;                   // Scratch for subsumption, indexed by clause
+    std::vector<int> subsumeMark;                       // Scratch for subsumption, indexed by variable
+    std::unique_ptr<BranchHeuristic> heuristic;
+    std::unique_ptr<RestartPolicy> restart;
+    PhaseSelector phases;
+    LearnedClauseDB db;
+    std::unique_ptr<LocalSearchBursts> walker; // Optional local search bursts that set the phases
+    const std::atomic<bool>* stop;    // Set by another thread to abandon the search, may be null
+    bool interrupted;                 // The last solve stopped without an answer
+    uint64_t conflicts;
+    uint64_t decisions;
+    uint64_t restarts;
+    uint64_t learnedLiterals;
+    uint64_t minimizedLiterals; // Removed from learned clauses by minimization
+    uint64_t strengthened;      // Antecedents shortened on the fly
+    uint64_t chronoBacktracks;
+    uint64_t subsumedLearned;   // Learned clauses deleted by subsumption
+    uint64_t strengthenedLearned; // Literals removed from learned clauses by self-subsuming resolution
+
+    CDCLSolver(const ClauseArena& formula, int numVariables, const std::string& heuristicName = DEFAULT_HEURISTIC,
+               const std::string& restartName = DEFAULT_RESTART)
+        : engine(formula, numVariables), seen(numVariables + 1, 0), chronoDistance(CHRONO_DISTANCE),
+          chronoMinConflicts(CHRONO_MIN_CONFLICTS), subsumeInterval(SUBSUME_INTERVAL), nextSubsume(SUBSUME_INTERVAL),
+          heuristic(makeHeuristic(heuristicName, numVariables)), restart(makeRestartPolicy(restartName)), phases(numVariables), stop(nullptr), interrupted(false), conflicts(0), decisions(0), restarts(0),
+          learnedLiterals(0), minimizedLiterals(0), strengthened(0), chronoBacktracks(0), subsumedLearned(0),
+          strengthenedLearned(0) {}
+
+    // Fix lit for the whole search, before it starts. Returns false if that contradicts the formula.
+    bool addUnit(int lit) {
+        if (!engine.enqueue(lit)) engine.inconsistent = true;
+        return !engine.inconsistent;
+    }
+
+
+    // Bit of the decision level of var in a 32-bit summary of a set of levels
+    uint32_t abstractLevel(int var) const { return 1u << (engine.level[var] & 31); }
+
+    // Whether lit is implied by the literals already marked seen, following the implication graph.
+    // Literals visited on the way are marked too and recorded in analyzeToClear, unless it fails.
+    bool litRedundant(int lit, uint32_t abstractLevels) {
+        analyzeStack.clear();
+        analyzeStack.push_back(lit);
+        size_t top = analyzeToClear.size();
+        while (!analyzeStack.empty()) {
+            int q = analyzeStack.back();
+            analyzeStack.pop_back();
+            ClauseRef r = engine.reason[litVar(q)];
+            const int* lits = engine.clauses.lits(r);
+            uint32_t size = engine.clauses.clauseSize(r);
+            for (uint32_t j = 1; j < size; j++) {
+                int l = lits[j];
+                int var = litVar(l);
+                if (seen[var] || engine.level[var] == 0) continue;
+                // A decision, or a level absent from the clause, cannot be implied by it
+                if (engine.reason[var] == CLAUSE_REF_UNDEF || !(abstractLevel(var) & abstractLevels)) {
+                    for (size_t k = top; k < analyzeToClear.size(); k++) seen[litVar(analyzeToClear[k])] = 0;
+                    analyzeToClear.resize(top);
+                    return false;
+                }
+                seen[var] = 1;
+                analyzeStack.push_back(l);
+                analyzeToClear.push_back(l);
+            }
+        }
+        return true;
+    }
+
+    // Remove from the learned clause every literal implied by the others
+    void minimize(std::vector<int>& out) {
+        uint32_t abstractLevels = 0;
+        for (size_t i = 1; i < out.size(); i++) abstractLevels |= abstractLevel(litVar(out[i]));
+        analyzeToClear.assign(out.begin(), out.end());
+        size_t j = 1;
+        for (size_t i = 1; i < out.size(); i++) {
+            int var = litVar(out[i]);
+            if (engine.reason[var] == CLAUSE_REF_UNDEF || !litRedundant(out[i], abstractLevels)) out[j++] = out[i];
+        }
+        minimizedLiterals += out.size() - j;
+        out.resize(j);
+    }
+
+    // Shorten the antecedents recorded during analysis, once the search has backjumped. Each one loses
+    // its implied literal, is watched again on its best two literals, and propagates if it became unit.
+    void strengthenAntecedents() {
+        for (const std::pair<ClauseRef, int>& s : strengthen) {
+            ClauseRef cref = s.first;
+            engine.detachClause(cref);
+            int* lits = engine.clauses.lits(cref);
+            uint32_t size = engine.clauses.clauseSize(cref);
+            for (uint32_t k = 0; k < size; k++) {
+                if (lits[k] == s.second) {
+                    lits[k] = lits[size - 1];
+                    break;
+                }
+            }
+            engine.clauses.headers[cref].size = --size;
+
+            // Watch the literals that are not false first, then the false ones assigned last
+            for (uint32_t w = 0; w < 2; w++) {
+                uint32_t best = w;
+                for (uint32_t k = w + 1; k < size; k++) {
+                    if (watchRank(lits[k]) > watchRank(lits[best])) best = k;
+                }
+                std::swap(lits[w], lits[best]);
+            }
+            engine.attachClause(cref);
+            if (engine.assignment.litValue(lits[0]) == VALUE_UNASSIGNED && engine.assignment.litValue(lits[1]) == VALUE_FALSE) {
+                engine.enqueue(lits[0], cref, engine.level[litVar(lits[1])]);
+            }
+            strengthened++;
+        }
+        strengthen.clear();
+    }
+
+    // Preference of a literal as a watch: true, then unassigned, then false at the highest level
+    long watchRank(int lit) const {
+        int8_t val = engine.assignment.litValue(lit);
+        if (val == VALUE_TRUE) return (long)engine.numVariables() + 2;
+        if (val == VALUE_UNASSIGNED) return (long)engine.numVariables() + 1;
+        return engine.level[litVar(lit)];
+    }
+
+    // 1-UIP analysis of the conflicting clause, fills out with the learned clause (the asserting
+    // literal at position 0, a literal of the backjump level at position 1) and returns that level
+    int analyze(ClauseRef confl, std::vector<int>& out) {
+        const std::vector<int>& trail = engine.trail;
+        int pathCount = 0;  // Literals of the current level still to resolve away
+        int p = 0;
+        size_t index = trail.size();
+        out.clear();
+        out.push_back(0);
+        strengthen.clear();
+
+        do {
+            const int* lits = engine.clauses.lits(confl);
+            uint32_t size = engine.clauses.clauseSize(confl);
+            if (engine.clauses.headers[confl].flags & CLAUSE_FLAG_LEARNT) {
+                db.onUse(confl, engine.computeLBD(lits, size), conflicts);
+            }
+            // The implied literal sits at position 0 of its reason, only the conflict clause is read whole
+            uint32_t assignedAbove0 = 0; // Literals of the antecedent besides p outside level 0
+            for (uint32_t j = (p == 0 ? 0 : 1); j < size; j++) {
+                int q = lits[j];
+                int var = litVar(q);
+                if (engine.level[var] == 0) continue;
+                assignedAbove0++;
+                if (seen[var]) continue;
+                seen[var] = 1;
+                heuristic->bumpVariable(var);
+                if (engine.level[var] >= engine.decisionLevel()) {
+                    pathCount++;
+                } else {
+                    out.push_back(q);
+                }
+            }
+
+            // The resolvent always contains the antecedent minus p, if it is not larger they are equal and
+            // the antecedent holds without p
+            if (p != 0 && size > 2 && (out.size() - 1) + pathCount == assignedAbove0) {
+                strengthen.push_back(std::make_pair(confl, p));
+            }
+
+            // Next literal of the current level to resolve on, walking the trail backwards past the
+            // literals of lower levels that chronological backtracking left among them
+            while (!seen[litVar(trail[--index])] || engine.level[litVar(trail[index])] < engine.decisionLevel()) {}
+            p = trail[index];
+            confl = engine.reason[litVar(p)];
+            seen[litVar(p)] = 0;
+            pathCount--;
+        } while (pathCount > 0);
+        out[0] = -p;
+
+        minimize(out);
+
+        // Backjump to the highest level among the other literals, which is watched next to the UIP
+        int backjumpLevel = 0;
+        size_t maxIndex = 1;
+        for (size_t i = 1; i < out.size(); i++) {
+            int lvl = engine.level[litVar(out[i])];
+            if (lvl > backjumpLevel) {
+                backjumpLevel = lvl;
+                maxIndex = i;
+            }
+        }
+        if (out.size() > 1) std::swap(out[1], out[maxIndex]);
+
+        for (int lit : analyzeToClear) seen[litVar(lit)] = 0;
+        return backjumpLevel;
+    }
+
+    // Next decision literal, 0 once every variable is assigned
+    int pickBranchLiteral() {
+        int var = heuristic->pickBranchVariable(engine.assignment);
+        return var == 0 ? 0 : phases.pick(var);
+    }
+
+    // Undo every decision level above the given one, the literals of lower levels past it stay
+    void cancelUntil(int level) {
+        if (engine.decisionLevel() <= level) return;
+        for (size_t i = engine.trailLim[level]; i < engine.trail.size(); i++) {
+            int lit = engine.trail[i];
+            if (engine.level[litVar(lit)] <= level) continue;
+            heuristic->onUnassign(litVar(lit));
+            phases.save(lit);
+        }
+        engine.cancelUntil(level);
+    }
+
+    // Remove lit from a learned clause, which is detached meanwhile. A clause left with one literal
+    // asserts it at level 0 and is deleted, if that literal is already false the formula is refuted.
+    void strengthenLearned(ClauseRef cref, int lit) {
+        engine.detachClause(cref);
+        int* lits = engine.clauses.lits(cref);
+        uint32_t size = engine.clauses.clauseSize(cref);
+        for (uint32_t k = 0; k < size; k++) {
+            if (lits[k] == lit) {
+                lits[k] = lits[size - 1];
+                break;
+            }
+        }
+        engine.clauses.headers[cref].size = --size;
+        std::vector<ClauseRef>& list = learnedOccurs[litIndex(lit)];
+        list.erase(std::find(list.begin(), list.end(), cref));
+        signatures[cref] = clauseSignature(lits, size);
+        strengthenedLearned++;
+        if (size == 1) {
+            if (!engine.enqueue(lits[0], CLAUSE_REF_UNDEF, 0)) engine.inconsistent = true;
+            db.remove(engine, cref);
+        } else {
+            engine.attachClause(cref);
+        }
+    }
+
+    // Backward subsumption at level 0 with every clause, shortest first, against the learned clauses
+    // whose literals are all unassigned (none of them is a reason). This round only changes learned
+    // clauses, so nothing is lost when the learned clause that subsumed them is reduced away later.
+    void subsumeLearned() {
+        nextSubsume = conflicts + subsumeInterval;
+        if (subsumeMark.empty()) {
+            subsumeMark.assign(engine.numVariables() + 1, 0);
+            learnedOccurs.resize(2 * (engine.numVariables() + 1));
+        }
+        signatures.resize(engine.clauses.size());
+        for (std::vector<ClauseRef>& list : learnedOccurs) list.clear();
+        for (ClauseRef cref : db.learnts) {
+            const int* lits = engine.clauses.lits(cref);
+            uint32_t size = engine.clauses.clauseSize(cref);
+            bool unassigned = true;
+            for (uint32_t k = 0; k < size && unassigned; k++) unassigned = engine.assignment.litValue(lits[k]) == VALUE_UNASSIGNED;
+            if (!unassigned) continue;
+            for (uint32_t k = 0; k < size; k++) learnedOccurs[litIndex(lits[k])].push_back(cref);
+        }
+
+        std::vector<std::pair<uint32_t, ClauseRef>> bySize;
+        for (ClauseRef cref = 0; cref < engine.clauses.size(); cref++) {
+            if (engine.clauses.headers[cref].flags & CLAUSE_FLAG_DELETED) continue;
+            signatures[cref] = clauseSignature(engine.clauses.lits(cref), engine.clauses.clauseSize(cref));
+            bySize.push_back(std::make_pair(engine.clauses.clauseSize(cref), cref));
+        }
+        std::sort(bySize.begin(), bySize.end());
+        std::vector<ClauseRef> queue;
+        for (const std::pair<uint32_t, ClauseRef>& c : bySize) queue.push_back(c.second);
+
+        std::vector<ClauseRef> candidates;
+        bool changed = false;
+        for (size_t q = 0; q < queue.size(); q++) {
+            ClauseRef c = queue[q];
+            if (engine.clauses.headers[c].flags & CLAUSE_FLAG_DELETED) continue;
+            const int* lits = engine.clauses.lits(c);
+            uint32_t size = engine.clauses.clauseSize(c);
+
+            // Every clause c subsumes, even with one literal negated, contains its rarest variable
+            int best = lits[0];
+            size_t bestCount = SIZE_MAX;
+            for (uint32_t k = 0; k < size; k++) {
+                size_t count = learnedOccurs[litIndex(lits[k])].size() + learnedOccurs[litIndex(-lits[k])].size();
+                if (count < bestCount) {
+                    best = lits[k];
+                    bestCount = count;
+                }
+            }
+            if (bestCount == 0) continue;
+            candidates.assign(learnedOccurs[litIndex(best)].begin(), learnedOccurs[litIndex(best)].end());
+            candidates.insert(candidates.end(), learnedOccurs[litIndex(-best)].begin(), learnedOccurs[litIndex(-best)].end());
+
+            for (ClauseRef d : candidates) {
+                if (d == c || (engine.clauses.headers[d].flags & CLAUSE_FLAG_DELETED)) continue;
+                if (engine.clauses.clauseSize(d) < size || (signatures[c] & ~signatures[d])) continue;
+                int result = subsumes(lits, size, engine.clauses.lits(d), engine.clauses.clauseSize(d), subsumeMark);
+                if (result == 0) {
+                    if (engine.clauses.headers[c].flags & CLAUSE_FLAG_LEARNT) db.inherit(c, d);
+                    db.remove(engine, d);
+                    subsumedLearned++;
+                    changed = true;
+                } else if (result != SUBSUME_FAILED) {
+                    strengthenLearned(d, -result);
+                    if (!(engine.clauses.headers[d].flags & CLAUSE_FLAG_DELETED)) queue.push_back(d);
+                    changed = true;
+                }
+            }
+        }
+        if (changed) db.collect(engine);
+    }
+
+    // Level of the conflicting clause, the highest among its literals. If only one literal sits at that
+    // level the clause should have implied it earlier: the search backtracks below it and the clause
+    // asserts it there, and -1 is returned. Otherwise the search backtracks to the conflict level.
+    int conflictLevel(ClauseRef confl) {
+        int* lits = engine.clauses.lits(confl);
+        uint32_t size = engine.clauses.clauseSize(confl);
+        int maxLevel = 0;
+        uint32_t atMax = 0, maxK = 0;
+        for (uint32_t k = 0; k < size; k++) {
+            int lvl = engine.level[litVar(lits[k])];
+            if (lvl > maxLevel) {
+                maxLevel = lvl;
+                atMax = 1;
+                maxK = k;
+            } else if (lvl == maxLevel) {
+                atMax++;
+            }
+        }
+        if (maxLevel == 0 || atMax > 1) {
+            cancelUntil(maxLevel);
+            return maxLevel;
+        }
+
+        // Watch the missed literal and the highest of the others, then assert it
+        engine.detachClause(confl);
+        std::swap(lits[0], lits[maxK]);
+        uint32_t secondK = 1;
+        for (uint32_t k = 2; k < size; k++) {
+            if (engine.level[litVar(lits[k])] > engine.level[litVar(lits[secondK])]) secondK = k;
+        }
+        std::swap(lits[1], lits[secondK]);
+        engine.attachClause(confl);
+        cancelUntil(maxLevel - 1);
+        engine.enqueue(lits[0], confl, engine.level[litVar(lits[1])]);
+        return -1;
+    }
+
+    // Run the search to completion, returns true with a full model in engine.assignment if satisfiable.
+    // Returns false with interrupted set if the stop flag was raised first.
+    bool solve() {
+        interrupted = false;
+        if (engine.inconsistent) return false;
+        for (;;) {
+            ClauseRef confl = engine.propagate();
+            if (confl != CLAUSE_REF_UNDEF) {
+                conflicts++;
+                if (engine.decisionLevel() == 0) return false;
+                phases.onConflict(engine.assignment, engine.trail.size());
+                // With literals out of level order the conflict can sit below the current level
+                int level = conflictLevel(confl);
+                if (level == 0) return false;
+                if (level < 0) continue;
+
+                int backjumpLevel = analyze(confl, learnt);
+                heuristic->endConflict();
+                db.endConflict();
+                uint32_t lbd = engine.computeLBD(learnt.data(), (uint32_t)learnt.size());
+                restart->onConflict(lbd);
+                if (chronoDistance > 0 && level - backjumpLevel > chronoDistance && conflicts > chronoMinConflicts) {
+                    chronoBacktracks++;
+                    cancelUntil(level - 1);
+                } else {
+                    cancelUntil(backjumpLevel);
+                }
+                learnedLiterals += learnt.size();
+                if (learnt.size() == 1) {
+                    engine.enqueue(learnt[0], CLAUSE_REF_UNDEF, 0);
+                } else {
+                    ClauseRef cref = engine.addClause(learnt, CLAUSE_FLAG_LEARNT);
+                    db.add(cref, lbd, conflicts);
+                    engine.enqueue(learnt[0], cref, backjumpLevel);
+                }
+                strengthenAntecedents();
+                continue;
+            }
+
+            if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+                interrupted = true;
+                return false;
+            }
+            if (restart->shouldRestart()) {
+                restarts++;
+                restart->onRestart();
+                cancelUntil(0);
+                if (subsumeInterval > 0 && conflicts >= nextSubsume) {
+                    subsumeLearned();
+                    if (engine.inconsistent) return false;
+                }
+                continue;
+            }
+            if (db.shouldReduce(conflicts)) db.reduce(engine, conflicts);
+            // After a burst the decisions restart from the root towards its best assignment, a model
+            // found by it is then rebuilt without a conflict
+            if (walker != nullptr && walker->due(conflicts)) {
+                walker->run(engine.assignment.values, conflicts);
+                cancelUntil(0);
+                walker->savePhases(phases.saved);
+                continue;
+            }
+
+            int lit = pickBranchLiteral();
+            if (lit == 0) return true;
+            decisions++;
+            engine.newDecisionLevel();
+            engine.enqueue(lit);
+        }
+    }
+};
+
+#endif
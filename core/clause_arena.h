@@ -0,0 +1,118 @@
+#ifndef CLAUSE_ARENA_H
+#define CLAUSE_ARENA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Reference to a clause inside a ClauseArena (index of its header)
+typedef uint32_t ClauseRef;
+#define CLAUSE_REF_UNDEF UINT32_MAX
+
+// Clause header flags
+#define CLAUSE_FLAG_NONE 0u
+#define CLAUSE_FLAG_LEARNT 1u // Derived by conflict analysis, not part of the original formula
+#define CLAUSE_FLAG_DELETED 2u // Waiting to be removed by the next compaction
+
+struct ClauseHeader {
+    uint32_t offset; // Position of the first literal in the literal pool
+    uint32_t size;   // Number of literals
+    uint32_t flags;
+};
+
+// Read-only window onto the literals of one clause, so clauses can be walked with range-for
+struct ClauseView {
+    const int* lits;
+    uint32_t length;
+
+    const int* begin() const { return lits; }
+    const int* end() const { return lits + length; }
+    uint32_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    int operator[](uint32_t i) const { return lits[i]; }
+};
+
+// Flat clause storage: all literals of all clauses live in one contiguous pool and each clause
+// is described by a small header. Copying a formula is two vector copies instead of one
+// allocation per clause, and visiting a clause is a linear read of the pool.
+class ClauseArena {
+public:
+    std::vector<int> literals;
+    std::vector<ClauseHeader> headers;
+
+    class const_iterator {
+        const ClauseArena* arena;
+        ClauseRef cref;
+    public:
+        const_iterator(const ClauseArena* a, ClauseRef c) : arena(a), cref(c) {}
+        ClauseView operator*() const { return (*arena)[cref]; }
+        const_iterator& operator++() { cref++; return *this; }
+        bool operator!=(const const_iterator& other) const { return cref != other.cref; }
+        bool operator==(const const_iterator& other) const { return cref == other.cref; }
+    };
+
+    void reserve(size_t numClauses, size_t numLiterals) {
+        headers.reserve(numClauses);
+        literals.reserve(numLiterals);
+    }
+
+    void clear() {
+        headers.clear();
+        literals.clear();
+    }
+
+    ClauseRef addClause(const int* begin, const int* end, uint32_t flags = CLAUSE_FLAG_NONE) {
+        ClauseHeader header;
+        header.offset = (uint32_t)literals.size();
+        header.size = (uint32_t)(end - begin);
+        header.flags = flags;
+        literals.insert(literals.end(), begin, end);
+        headers.push_back(header);
+        return (ClauseRef)(headers.size() - 1);
+    }
+
+    ClauseRef addClause(const std::vector<int>& clause, uint32_t flags = CLAUSE_FLAG_NONE) {
+        return addClause(clause.data(), clause.data() + clause.size(), flags);
+    }
+
+    // Number of clauses
+    size_t size() const { return headers.size(); }
+    bool empty() const { return headers.empty(); }
+
+    ClauseView operator[](ClauseRef cref) const {
+        const ClauseHeader& header = headers[cref];
+        return ClauseView{literals.data() + header.offset, header.size};
+    }
+
+    // Mutable access to the literals of a clause (e.g. to reorder watched literals)
+    int* lits(ClauseRef cref) { return literals.data() + headers[cref].offset; }
+    const int* lits(ClauseRef cref) const { return literals.data() + headers[cref].offset; }
+
+    uint32_t clauseSize(ClauseRef cref) const { return headers[cref].size; }
+
+    // Remove the clauses flagged CLAUSE_FLAG_DELETED and close the gaps in place, keeping the order of
+    // the others. remap[old] receives the new reference of each clause, CLAUSE_REF_UNDEF if it was removed.
+    void compact(std::vector<ClauseRef>& remap) {
+        remap.assign(headers.size(), CLAUSE_REF_UNDEF);
+        uint32_t litPos = 0;
+        ClauseRef next = 0;
+        for (ClauseRef cref = 0; cref < headers.size(); cref++) {
+            ClauseHeader header = headers[cref];
+            if (header.flags & CLAUSE_FLAG_DELETED) continue;
+            // Clauses only move towards the front, so a forward copy is safe
+            std::copy(literals.begin() + header.offset, literals.begin() + header.offset + header.size,
+                      literals.begin() + litPos);
+            header.offset = litPos;
+            litPos += header.size;
+            headers[next] = header;
+            remap[cref] = next++;
+        }
+        headers.resize(next);
+        literals.resize(litPos);
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, (ClauseRef)headers.size()); }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef CLAUSE_DB_H
+#define CLAUSE_DB_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include "get_time.h"
+#include "propagator.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Tiers of learned clauses, by literal block distance
+#define TIER_CORE 0  // LBD <= TIER_CORE_LBD, kept forever
+#define TIER_MID 1   // LBD <= TIER_MID_LBD, kept while it keeps taking part in conflicts
+#define TIER_LOCAL 2 // Everything else, the least active half is dropped at each reduction
+#define TIER_CORE_LBD 2
+#define TIER_MID_LBD 6
+#define TIER_MID_UNUSED 10000 // Conflicts without use after which a mid-tier clause falls to the local tier
+
+#define FIRST_REDUCE 2000
+#define REDUCE_INCREMENT 300
+
+struct LearnedInfo {
+    uint32_t lbd;
+    uint32_t tier;
+    double activity;
+    uint64_t lastUsed; // Conflict count when it last took part in conflict analysis
+};
+
+// Manager of the learned clauses of one propagation engine.
+// Clauses are filed into tiers by LBD when learned, and move up when a later use finds a lower LBD.
+// Every few thousand conflicts the database is reduced: unused mid-tier clauses are demoted, the least
+// active half of the local tier is deleted, and the engine's clause arena is compacted.
+class LearnedClauseDB {
+public:
+    std::vector<ClauseRef> learnts;  // Live learned clauses
+    std::vector<LearnedInfo> info;   // Indexed by clause reference, only meaningful for learned clauses
+    double increment;
+    double decay;
+    uint64_t nextReduce;
+    uint64_t reduceInterval;
+    std::vector<ClauseRef> remap;    // Scratch for compaction
+
+    // Stats
+    uint64_t reductions;
+    uint64_t deleted;
+    double reduceTime;
+    size_t tierSize[3];
+
+    LearnedClauseDB()
+        : increment(1.0), decay(0.999), nextReduce(FIRST_REDUCE), reduceInterval(FIRST_REDUCE),
+          reductions(0), deleted(0), reduceTime(0.0), tierSize{0, 0, 0} {}
+
+    static uint32_t tierOf(uint32_t lbd) {
+        return lbd <= TIER_CORE_LBD ? TIER_CORE : lbd <= TIER_MID_LBD ? TIER_MID : TIER_LOCAL;
+    }
+
+    // Record a clause just added to the engine
+    void add(ClauseRef cref, uint32_t lbd, uint64_t conflicts) {
+        if (info.size() <= cref) info.resize(cref + 1);
+        uint32_t tier = tierOf(lbd);
+        info[cref] = LearnedInfo{lbd, tier, increment, conflicts};
+        learnts.push_back(cref);
+        tierSize[tier]++;
+    }
+
+    // The learned clause took part in conflict analysis, lbd being its current LBD
+    void onUse(ClauseRef cref, uint32_t lbd, uint64_t conflicts) {
+        LearnedInfo& c = info[cref];
+        c.lastUsed = conflicts;
+        if ((c.activity += increment) > 1e20) {
+            for (ClauseRef r : learnts) info[r].activity *= 1e-20;
+            increment *= 1e-20;
+        }
+        if (lbd < c.lbd) {
+            c.lbd = lbd;
+            uint32_t tier = tierOf(lbd);
+            if (tier < c.tier) {
+                tierSize[c.tier]--;
+                tierSize[tier]++;
+                c.tier = tier;
+            }
+        }
+    }
+
+    void endConflict() { increment /= decay; }
+
+    bool shouldReduce(uint64_t conflicts) const { return conflicts >= nextReduce; }
+
+    // A clause is locked while it is the reason of an assigned literal
+    static bool locked(const Propagator& engine, ClauseRef cref) {
+        int first = engine.clauses.lits(cref)[0];
+        return engine.assignment.litValue(first) == VALUE_TRUE && engine.reason[litVar(first)] == cref;
+    }
+
+    // Flag a learned clause for deletion, it is dropped at the next collect. Only reductions count
+    // towards deleted, callers keep their own stats.
+    void remove(Propagator& engine, ClauseRef cref) {
+        engine.clauses.headers[cref].flags |= CLAUSE_FLAG_DELETED;
+        tierSize[info[cref].tier]--;
+    }
+
+    // Learned clause c subsumes learned clause d, which is removed: c takes over its LBD and tier if better
+    void inherit(ClauseRef c, ClauseRef d) {
+        LearnedInfo& kept = info[c];
+        const LearnedInfo& gone = info[d];
+        kept.lbd = std::min(kept.lbd, gone.lbd);
+        kept.activity = std::max(kept.activity, gone.activity);
+        kept.lastUsed = std::max(kept.lastUsed, gone.lastUsed);
+        if (gone.tier < kept.tier) {
+            tierSize[kept.tier]--;
+            tierSize[gone.tier]++;
+            kept.tier = gone.tier;
+        }
+    }
+
+    // Compact the arena and move the bookkeeping to the new references
+    void collect(Propagator& engine) {
+        engine.collectGarbage(remap);
+        size_t j = 0;
+        for (ClauseRef cref : learnts) {
+            ClauseRef moved = remap[cref];
+            if (moved == CLAUSE_REF_UNDEF) continue;
+            info[moved] = info[cref]; // Clauses only move to lower references, already visited
+            learnts[j++] = moved;
+        }
+        learnts.resize(j);
+        info.resize(engine.clauses.size());
+    }
+
+    void reduce(Propagator& engine, uint64_t conflicts) {
+        timer t;
+        t.start();
+
+        // Demote the mid-tier clauses that stopped being useful, gather the local tier
+        std::vector<ClauseRef> local;
+        for (ClauseRef cref : learnts) {
+            LearnedInfo& c = info[cref];
+            if (c.tier == TIER_MID && conflicts - c.lastUsed > TIER_MID_UNUSED) {
+                c.tier = TIER_LOCAL;
+                tierSize[TIER_MID]--;
+                tierSize[TIER_LOCAL]++;
+            }
+            if (c.tier == TIER_LOCAL && !locked(engine, cref)) local.push_back(cref);
+        }
+
+        // Delete the least active half of the local tier
+        std::sort(local.begin(), local.end(), [this](ClauseRef a, ClauseRef b) {
+            return info[a].activity < info[b].activity;
+        });
+        size_t toDelete = local.size() / 2;
+        for (size_t i = 0; i < toDelete; i++) remove(engine, local[i]);
+        deleted += toDelete;
+        collect(engine);
+
+        reductions++;
+        reduceInterval += REDUCE_INCREMENT;
+        nextReduce = conflicts + reduceInterval;
+        reduceTime += t.stop();
+    }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef CLAUSE_STATE_H
+#define CLAUSE_STATE_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include "occurrences.h"
+#include <cstdint>
+#include <vector>
+
+// Per-worker view of a shared, read-only formula under the current assignment.
+// Every clause counts its true literals and every literal counts the unsatisfied clauses it still
+// occurs in. The counters are updated through the occurrence list of each literal as it is assigned
+// or unassigned, so newly satisfied clauses and newly pure variables are found with work
+// proportional to what changed instead of a pass over the formula.
+// Optionally the clause-length scores of the Jeroslow-Wang and MOMS heuristics are kept the same way:
+// every clause also counts its false literals, and a clause whose number of non-false literals changes
+// moves its contribution to the scores of its literals.
+class ClauseState {
+public:
+    const ClauseArena* formula;
+    const OccurrenceLists* occurs;
+    std::vector<uint32_t> trueLits;   // Per clause, number of true literals (satisfied when > 0)
+    std::vector<uint32_t> liveOccurs; // Per literal (litIndex), number of unsatisfied clauses containing it
+    size_t numSatisfied;
+    size_t applied;                   // Length of the trail prefix accounted for
+    std::vector<int> candidates;      // Variables whose occurrences changed and may now be pure or free
+    bool scored;                      // Whether the scores below are kept, set before reset
+    std::vector<uint32_t> falseLits;  // Per clause, number of false literals
+    std::vector<uint64_t> lengthScores; // Per literal, sum of lengthWeight over the unsatisfied clauses containing it
+    std::vector<uint32_t> binaryOccurs; // Per literal, unsatisfied clauses containing it with two literals left
+
+    ClauseState() : formula(nullptr), occurs(nullptr), numSatisfied(0), applied(0), scored(false) {}
+
+    // 2^-length in fixed point, so the sums stay exact when clauses are added back on a backtrack
+    static uint64_t lengthWeight(uint32_t length) { return length >= 32 ? 1 : 1ull << (32 - length); }
+
+    // Add or remove the contribution of an unsatisfied clause to the scores of its literals
+    void scoreClause(ClauseRef cref, bool add) {
+        ClauseView clause = (*formula)[cref];
+        uint32_t length = clause.size() - falseLits[cref];
+        uint64_t weight = lengthWeight(length);
+        for (int lit : clause) {
+            size_t i = litIndex(lit);
+            if (add) {
+                lengthScores[i] += weight;
+                if (length == 2) binaryOccurs[i]++;
+            } else {
+                lengthScores[i] -= weight;
+                if (length == 2) binaryOccurs[i]--;
+            }
+        }
+    }
+
+    // Start over from the empty assignment, every variable is a candidate
+    void reset(const ClauseArena& f, const OccurrenceLists& o) {
+        formula = &f;
+        occurs = &o;
+        trueLits.assign(formula->size(), 0);
+        size_t numLits = occurs->start.size() - 1;
+        liveOccurs.resize(numLits);
+        for (size_t i = 0; i < numLits; i++) {
+            liveOccurs[i] = occurs->start[i + 1] - occurs->start[i];
+        }
+        numSatisfied = 0;
+        applied = 0;
+        candidates.clear();
+        for (int var = 1; var < (int)(numLits / 2); var++) {
+            candidates.push_back(var);
+        }
+        if (scored) {
+            falseLits.assign(formula->size(), 0);
+            lengthScores.assign(numLits, 0);
+            binaryOccurs.assign(numLits, 0);
+            for (ClauseRef cref = 0; cref < formula->size(); cref++) scoreClause(cref, true);
+        }
+    }
+
+    // The clauses containing lit, which just became false (delta 1) or free again (delta -1), change length
+    void shorten(int lit, int delta) {
+        for (ClauseRef cref : (*occurs)[lit]) {
+            bool unsatisfied = trueLits[cref] == 0;
+            if (unsatisfied) scoreClause(cref, false);
+            falseLits[cref] += delta;
+            if (unsatisfied) scoreClause(cref, true);
+        }
+    }
+
+    void assign(int lit) {
+        for (ClauseRef cref : (*occurs)[lit]) {
+            if (trueLits[cref]++ > 0) continue;
+            numSatisfied++;
+            if (scored) scoreClause(cref, false);
+            for (int other : (*formula)[cref]) {
+                if (--liveOccurs[litIndex(other)] == 0) candidates.push_back(litVar(other));
+            }
+        }
+        if (scored) shorten(-lit, 1);
+    }
+
+    void unassign(int lit) {
+        if (scored) shorten(-lit, -1);
+        for (ClauseRef cref : (*occurs)[lit]) {
+            if (--trueLits[cref] > 0) continue;
+            numSatisfied--;
+            if (scored) scoreClause(cref, true);
+            for (int other : (*formula)[cref]) {
+                liveOccurs[litIndex(other)]++;
+            }
+        }
+        // The variable is free again and may still be pure
+        candidates.push_back(litVar(lit));
+    }
+
+    // Account for the literals appended to the trail since the last call
+    void sync(const std::vector<int>& trail) {
+        while (applied < trail.size()) assign(trail[applied++]);
+    }
+
+    // Forget the trail literals past the given length, must run before the trail itself shrinks
+    void backtrack(const std::vector<int>& trail, size_t trailSize) {
+        while (applied > trailSize) unassign(trail[--applied]);
+    }
+
+    uint32_t liveCount(int lit) const { return liveOccurs[litIndex(lit)]; }
+
+    uint64_t lengthScore(int lit) const { return lengthScores[litIndex(lit)]; }
+
+    uint32_t binaryCount(int lit) const { return binaryOccurs[litIndex(lit)]; }
+
+    bool allSatisfied() const { return numSatisfied == trueLits.size(); }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef DIMACS_H
+#define DIMACS_H
+
+#include "clause_arena.h"
+#include <iostream>
+#include <fstream>
+#include <sstream> // for std::istringstream
+#include <string>
+#include <vector>
+
+// Function to read a CNF file in DIMACS format and populate the formula
+inline bool readDIMACSCNF(const std::string& filename, ClauseArena& formula, int& numVariables) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int numClauses;
+    std::vector<int> clause; // Reused buffer for the clause being read
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == 'c') continue; // Skip comments and empty lines
+        if (line[0] == 'p') {
+            std::istringstream iss(line);
+            std::string tmp;
+            if (!(iss >> tmp >> tmp >> numVariables >> numClauses)) {
+                std::cerr << "Error reading header line: " << line << std::endl;
+                return false;
+            }
+            // Reserve space for clauses, guessing an average clause length of 4
+            formula.reserve(numClauses, (size_t)numClauses * 4);
+            continue;
+        }
+        std::istringstream iss(line);
+        clause.clear();
+        int lit;
+        while (iss >> lit && lit != 0) { // Read literals until 0
+            clause.push_back(lit);
+        }
+        if (!clause.empty()) formula.addClause(clause);
+    }
+    return true;
+}
+
+#endif
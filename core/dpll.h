@@ -0,0 +1,113 @@
+#ifndef DPLL_H
+#define DPLL_H
+
+#include "propagator.h"
+#include "clause_state.h"
+#include "heuristics.h"
+#include "phase.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// A guiding path fixes the root of a subtree: its literals hold for every node below it
+typedef std::vector<int> GuidingPath;
+
+// In-place DPLL exploration of one subtree.
+// Decisions are pushed on the engine's trail and a conflict undoes only the levels above the most
+// recent decision whose other branch is still open, so a node costs O(depth) memory instead of a
+// copy of the formula. Open branches close to the root can be split off as guiding paths for other
+// workers. The original formula and its occurrence lists are shared read-only between all workers,
+// each of which only keeps its own counters of what is satisfied.
+class DPLLSearch {
+public:
+    std::shared_ptr<const ClauseArena> formula;     // Original formula, shared by every worker
+    std::shared_ptr<const OccurrenceLists> occurs;  // Occurrence lists of the original formula
+    Propagator engine;
+    ClauseState live;           // Satisfied clauses and live occurrences at the current node
+    GuidingPath rootPath;       // Path of the subtree being explored
+    std::vector<int> decisions; // Decision literal of each level (index level - 1)
+    std::vector<char> closed;   // Whether the other branch of each level is already explored or handed off
+    std::unique_ptr<BranchHeuristic> heuristic; // Picks the variable of each decision
+    PhaseSelector phases;                       // Picks its polarity
+
+    DPLLSearch(std::shared_ptr<const ClauseArena> f, std::shared_ptr<const OccurrenceLists> o, int numVariables,
+               const std::string& heuristicName = DEFAULT_HEURISTIC)
+        : formula(f), occurs(o), engine(*f, numVariables), heuristic(makeHeuristic(heuristicName, numVariables)),
+          phases(numVariables) {
+        live.scored = heuristic->usesClauseScores();
+        heuristic->attach(live);
+    }
+
+    // Start exploring the subtree fixed by path, returns false if the path is already contradictory
+    bool start(const GuidingPath& path) {
+        rootPath = path;
+        decisions.clear();
+        closed.clear();
+        live.reset(*formula, *occurs);
+        heuristic->unassignTrail(engine.trail, 0);
+        phases.saveTrail(engine.trail, 0);
+        if (!engine.reset()) return false;
+        for (int lit : path) {
+            if (!engine.enqueue(lit)) return false;
+        }
+        return true;
+    }
+
+    int decisionLevel() const { return (int)decisions.size(); }
+
+    // Let the heuristics learn from the clause that propagation found falsified
+    void conflict(ClauseRef confl) {
+        for (int lit : engine.clauses[confl]) heuristic->bumpVariable(litVar(lit));
+        heuristic->endConflict();
+        phases.onConflict(engine.assignment, engine.trail.size());
+    }
+
+    // Decision literal for var: the heuristic's polarity if it has one, the saved phase otherwise
+    int branchLiteral(int var) const {
+        int lit = heuristic->pickPolarity(var);
+        return lit != 0 ? lit : phases.pick(var);
+    }
+
+    // Branch on lit below the current node
+    void decide(int lit) {
+        engine.newDecisionLevel();
+        engine.enqueue(lit);
+        decisions.push_back(lit);
+        closed.push_back(0);
+    }
+
+    // Move to the deepest open branch after a dead end, returns false once the subtree is exhausted
+    bool backtrack() {
+        int level = decisionLevel();
+        while (level > 0 && closed[level - 1]) level--;
+        if (level == 0) return false;
+
+        int lit = decisions[level - 1];
+        live.backtrack(engine.trail, engine.trailLim[level - 1]);
+        heuristic->unassignTrail(engine.trail, engine.trailLim[level - 1]);
+        phases.saveTrail(engine.trail, engine.trailLim[level - 1]);
+        engine.cancelUntil(level - 1);
+        decisions.resize(level - 1);
+        closed.resize(level - 1);
+
+        // Take the other branch, whose sibling has just been refuted
+        decide(-lit);
+        closed.back() = 1;
+        return true;
+    }
+
+    // Hand off the open branch closest to the root as a guiding path, returns false if none is open
+    bool split(GuidingPath& path) {
+        int level = 0;
+        while (level < decisionLevel() && closed[level]) level++;
+        if (level == decisionLevel()) return false;
+
+        path = rootPath;
+        path.insert(path.end(), decisions.begin(), decisions.begin() + level);
+        path.push_back(-decisions[level]);
+        closed[level] = 1;
+        return true;
+    }
+};
+
+#endif
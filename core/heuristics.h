@@ -0,0 +1,178 @@
+#ifndef HEURISTICS_H
+#define HEURISTICS_H
+
+#include "assignment.h"
+#include "clause_state.h"
+#include "var_heap.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define DEFAULT_HEURISTIC "vsids"
+
+// Decision heuristic: picks the next variable to branch on.
+// The search reports the variables involved in each conflict and every variable it unassigns, so
+// heuristics can keep incremental state instead of scanning the assignment at each decision.
+class BranchHeuristic {
+public:
+    virtual ~BranchHeuristic() {}
+
+    // Unassigned variable to branch on, or 0 once every variable is assigned
+    virtual int pickBranchVariable(const Assignment& assignment) = 0;
+
+    // The variable took part in the conflict being handled
+    virtual void bumpVariable(int /*var*/) {}
+
+    // The current conflict has been handled
+    virtual void endConflict() {}
+
+    // The variable has just been unassigned by a backtrack
+    virtual void onUnassign(int /*var*/) {}
+
+    // Heuristics that score the clauses of the current node need the search to keep them in its
+    // clause state, which it then hands over with attach
+    virtual bool usesClauseScores() const { return false; }
+    virtual void attach(const ClauseState& /*state*/) {}
+
+    // Decision literal preferred for var, or 0 to leave the polarity to phase saving
+    virtual int pickPolarity(int /*var*/) const { return 0; }
+
+    // Report every literal of the trail past trailSize, before the trail shrinks to that size
+    void unassignTrail(const std::vector<int>& trail, size_t trailSize) {
+        for (size_t i = trailSize; i < trail.size(); i++) {
+            onUnassign(litVar(trail[i]));
+        }
+    }
+};
+
+// Lowest-numbered unassigned variable, the original static order
+class StaticOrderHeuristic : public BranchHeuristic {
+    int next; // No variable below it is unassigned
+
+public:
+    StaticOrderHeuristic() : next(1) {}
+
+    int pickBranchVariable(const Assignment& assignment) override {
+        while (next <= assignment.numVariables() && assignment.isAssigned(next)) next++;
+        return next <= assignment.numVariables() ? next : 0;
+    }
+
+    void onUnassign(int var) override {
+        if (var < next) next = var;
+    }
+};
+
+// Exponential VSIDS: every conflict bumps the activity of its variables by an increment that grows
+// geometrically, which decays all older bumps without touching them. Activities are rescaled only
+// when the increment gets close to overflowing. Unassigned variables wait in a heap by activity.
+class VSIDSHeuristic : public BranchHeuristic {
+    std::vector<double> activity;
+    double increment;
+    double decay;
+    VarHeap heap;
+
+public:
+    explicit VSIDSHeuristic(int numVariables, double d = 0.95)
+        : activity(numVariables + 1, 0.0), increment(1.0), decay(d), heap(activity) {
+        for (int var = 1; var <= numVariables; var++) heap.insert(var);
+    }
+
+    int pickBranchVariable(const Assignment& assignment) override {
+        while (!heap.empty()) {
+            int var = heap.removeMax();
+            if (!assignment.isAssigned(var)) return var;
+        }
+        return 0;
+    }
+
+    void bumpVariable(int var) override {
+        if ((activity[var] += increment) > 1e100) {
+            for (double& a : activity) a *= 1e-100;
+            increment *= 1e-100;
+        }
+        heap.increase(var);
+    }
+
+    void endConflict() override { increment /= decay; }
+
+    void onUnassign(int var) override { heap.insert(var); }
+};
+
+// Jeroslow-Wang, two-sided: every unsatisfied clause adds 2^-length to each of its literals, length
+// counting the literals not yet false. The variable with the highest total over its two literals is
+// picked, in the polarity with the higher score, so that the most short clauses get satisfied.
+// Only for DPLL search, whose clause state keeps the scores up to date.
+class JeroslowWangHeuristic : public BranchHeuristic {
+    const ClauseState* live;
+
+public:
+    JeroslowWangHeuristic() : live(nullptr) {}
+
+    bool usesClauseScores() const override { return true; }
+    void attach(const ClauseState& state) override { live = &state; }
+
+    int pickBranchVariable(const Assignment& assignment) override {
+        int best = 0;
+        uint64_t bestScore = 0;
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            if (assignment.isAssigned(var)) continue;
+            uint64_t score = live->lengthScore(var) + live->lengthScore(-var);
+            if (best == 0 || score > bestScore) {
+                best = var;
+                bestScore = score;
+            }
+        }
+        return best;
+    }
+
+    int pickPolarity(int var) const override { return live->lengthScore(-var) > live->lengthScore(var) ? -var : var; }
+};
+
+// MOMS, maximum occurrences in clauses of minimum size. After unit propagation the shortest
+// unsatisfied clauses are the binary ones, so the variable maximizing (b(x) + b(-x)) * 2^10 + b(x) * b(-x)
+// over its binary occurrences b is picked (the POSIT form, which favours balanced variables), with
+// ties broken by the Jeroslow-Wang scores. Only for DPLL search.
+class MOMSHeuristic : public BranchHeuristic {
+    const ClauseState* live;
+
+public:
+    MOMSHeuristic() : live(nullptr) {}
+
+    bool usesClauseScores() const override { return true; }
+    void attach(const ClauseState& state) override { live = &state; }
+
+    int pickBranchVariable(const Assignment& assignment) override {
+        int best = 0;
+        uint64_t bestScore = 0, bestTie = 0;
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            if (assignment.isAssigned(var)) continue;
+            uint64_t pos = live->binaryCount(var), neg = live->binaryCount(-var);
+            uint64_t score = ((pos + neg) << 10) + pos * neg;
+            uint64_t tie = live->lengthScore(var) + live->lengthScore(-var);
+            if (best == 0 || score > bestScore || (score == bestScore && tie > bestTie)) {
+                best = var;
+                bestScore = score;
+                bestTie = tie;
+            }
+        }
+        return best;
+    }
+
+    int pickPolarity(int var) const override {
+        uint32_t pos = live->binaryCount(var), neg = live->binaryCount(-var);
+        if (pos != neg) return neg > pos ? -var : var;
+        return live->lengthScore(-var) > live->lengthScore(var) ? -var : var;
+    }
+};
+
+// Build the heuristic named on the command line, nullptr if the name is unknown
+inline std::unique_ptr<BranchHeuristic> makeHeuristic(const std::string& name, int numVariables) {
+    if (name == "order") return std::unique_ptr<BranchHeuristic>(new StaticOrderHeuristic());
+    if (name == "vsids") return std::unique_ptr<BranchHeuristic>(new VSIDSHeuristic(numVariables));
+    if (name == "jw") return std::unique_ptr<BranchHeuristic>(new JeroslowWangHeuristic());
+    if (name == "moms") return std::unique_ptr<BranchHeuristic>(new MOMSHeuristic());
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include "assignment.h"
+#include "clause_state.h"
+#include "propagator.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define DEFAULT_LOOKAHEAD_DEPTH "6"
+#define LOOKAHEAD_CANDIDATES 24
+
+#define LOOKAHEAD_DECIDE 0   // A variable to branch on was picked
+#define LOOKAHEAD_IMPLIED 1  // Failed literals fixed their negation, the node has to be processed again
+#define LOOKAHEAD_CONFLICT 2 // Both polarities of some variable fail, the node is refuted
+
+// March-style lookahead for the splits near the root of the search tree.
+// The free variables occurring in the most unsatisfied clauses are probed: each polarity is
+// propagated on a temporary decision level, and the variable whose two branches both fix the most
+// variables is preferred (score 1024 * l * r + l + r), which keeps the two subtrees balanced and
+// small. A polarity that leads to a conflict is a failed literal, its negation holds at the node.
+class Lookahead {
+public:
+    std::vector<std::pair<uint32_t, int>> candidates; // (live occurrences, variable)
+    uint64_t probes;
+    uint64_t failedLiterals;
+
+    Lookahead() : probes(0), failedLiterals(0) {}
+
+    // Number of literals assigned by propagating lit, or -1 if that leads to a conflict
+    long probe(Propagator& engine, int lit) {
+        probes++;
+        size_t before = engine.trail.size();
+        engine.newDecisionLevel();
+        engine.enqueue(lit);
+        bool consistent = engine.propagate() == CLAUSE_REF_UNDEF;
+        long implied = (long)(engine.trail.size() - before);
+        engine.cancelUntil(engine.decisionLevel() - 1);
+        return consistent ? implied : -1;
+    }
+
+    // Look ahead at the current node, whose trail must be in sync with live. Returns one of the
+    // LOOKAHEAD_ codes, with the chosen variable in best (0 if every variable is assigned).
+    int select(Propagator& engine, const ClauseState& live, int& best) {
+        best = 0;
+        // Pending literals must be propagated below the temporary levels, not inside them
+        if (engine.propagate() != CLAUSE_REF_UNDEF) return LOOKAHEAD_CONFLICT;
+
+        const Assignment& assignment = engine.assignment;
+        candidates.clear();
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            if (!assignment.isAssigned(var)) candidates.push_back(std::make_pair(live.liveCount(var) + live.liveCount(-var), var));
+        }
+        if (candidates.empty()) return LOOKAHEAD_DECIDE;
+        size_t count = std::min(candidates.size(), (size_t)LOOKAHEAD_CANDIDATES);
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                          [](const std::pair<uint32_t, int>& a, const std::pair<uint32_t, int>& b) { return a.first > b.first; });
+
+        bool implied = false;
+        long bestScore = -1;
+        for (size_t i = 0; i < count; i++) {
+            int var = candidates[i].second;
+            if (assignment.isAssigned(var)) continue; // Fixed by a failed literal found earlier
+            long left = probe(engine, var);
+            long right = probe(engine, -var);
+            if (left < 0 || right < 0) {
+                if (left < 0 && right < 0) return LOOKAHEAD_CONFLICT;
+                failedLiterals++;
+                implied = true;
+                engine.enqueue(left < 0 ? -var : var);
+                if (engine.propagate() != CLAUSE_REF_UNDEF) return LOOKAHEAD_CONFLICT;
+                continue;
+            }
+            long score = 1024 * left * right + left + right;
+            if (score > bestScore) {
+                bestScore = score;
+                best = var;
+            }
+        }
+        return implied ? LOOKAHEAD_IMPLIED : LOOKAHEAD_DECIDE;
+    }
+};
+
+#endif
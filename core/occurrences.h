@@ -0,0 +1,57 @@
+#ifndef OCCURRENCES_H
+#define OCCURRENCES_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include <cstdint>
+#include <vector>
+
+// Read-only window onto the clauses containing one literal
+struct OccurrenceRange {
+    const ClauseRef* first;
+    const ClauseRef* last;
+
+    const ClauseRef* begin() const { return first; }
+    const ClauseRef* end() const { return last; }
+    size_t size() const { return last - first; }
+};
+
+// Per-literal occurrence index of a formula, stored flat: the clauses containing the literal with
+// dense index i are refs[start[i], start[i + 1]). Built once and shared read-only by every worker.
+class OccurrenceLists {
+public:
+    std::vector<uint32_t> start;
+    std::vector<ClauseRef> refs;
+
+    OccurrenceLists(const ClauseArena& formula, int numVariables) {
+        uint32_t numLits = 2 * (numVariables + 1);
+        start.assign(numLits + 1, 0);
+        for (const auto& clause : formula) {
+            for (int lit : clause) {
+                start[litIndex(lit) + 1]++;
+            }
+        }
+        for (uint32_t i = 0; i < numLits; i++) {
+            start[i + 1] += start[i];
+        }
+        refs.resize(start[numLits]);
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (ClauseRef cref = 0; cref < formula.size(); cref++) {
+            for (int lit : formula[cref]) {
+                refs[fill[litIndex(lit)]++] = cref;
+            }
+        }
+    }
+
+    OccurrenceRange operator[](int lit) const {
+        uint32_t i = litIndex(lit);
+        return OccurrenceRange{refs.data() + start[i], refs.data() + start[i + 1]};
+    }
+
+    uint32_t count(int lit) const {
+        uint32_t i = litIndex(lit);
+        return start[i + 1] - start[i];
+    }
+};
+
+#endif
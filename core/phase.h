@@ -0,0 +1,89 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "assignment.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#define REPHASE_INTERVAL 1000
+
+// Polarity of the decisions.
+// Every variable keeps the value it had when it was last unassigned (phase saving), so after a
+// backtrack or a restart the search goes straight back to the assignment it was building. On top of
+// that the longest conflict-free trails are remembered: the target since the last rephase and the best
+// since the last rephase to it. Every few thousand conflicts the saved phases are reset from one of
+// them, or to the original or inverted polarity, so the search does not stay stuck in one region.
+class PhaseSelector {
+public:
+    std::vector<int8_t> saved;   // Per variable, VALUE_TRUE or VALUE_FALSE
+    std::vector<int8_t> target;  // Values of the longest trail since the last rephase
+    std::vector<int8_t> best;    // Values of the longest trail since best was last used
+    size_t targetSize;
+    size_t bestSize;
+    uint64_t conflicts;
+    uint64_t nextRephase;
+    uint64_t rephases;
+
+    explicit PhaseSelector(int numVariables)
+        : saved(numVariables + 1, VALUE_TRUE), target(numVariables + 1, VALUE_UNASSIGNED),
+          best(numVariables + 1, VALUE_UNASSIGNED), targetSize(0), bestSize(0),
+          conflicts(0), nextRephase(REPHASE_INTERVAL), rephases(0) {}
+
+    // Decision literal for var
+    int pick(int var) const { return saved[var] == VALUE_FALSE ? -var : var; }
+
+    // Save the phase of lit, whose variable is being unassigned
+    void save(int lit) { saved[litVar(lit)] = lit > 0 ? VALUE_TRUE : VALUE_FALSE; }
+
+    // Save the phase of every literal of the trail past trailSize, before the trail shrinks to that size
+    void saveTrail(const std::vector<int>& trail, size_t trailSize) {
+        for (size_t i = trailSize; i < trail.size(); i++) save(trail[i]);
+    }
+
+    // A conflict was reached with the given number of variables assigned
+    void onConflict(const Assignment& assignment, size_t assigned) {
+        if (assigned > targetSize) {
+            targetSize = assigned;
+            target = assignment.values;
+        }
+        if (assigned > bestSize) {
+            bestSize = assigned;
+            best = assignment.values;
+        }
+        if (++conflicts >= nextRephase) rephase();
+    }
+
+    void rephase() {
+        // best, target, original, best, target, inverted, ...
+        switch (rephases % 6) {
+        case 0:
+        case 3:
+            copyAssigned(best);
+            bestSize = 0;
+            break;
+        case 1:
+        case 4:
+            copyAssigned(target);
+            break;
+        case 2:
+            std::fill(saved.begin(), saved.end(), VALUE_TRUE);
+            break;
+        case 5:
+            std::fill(saved.begin(), saved.end(), VALUE_FALSE);
+            break;
+        }
+        targetSize = 0;
+        rephases++;
+        nextRephase = conflicts + REPHASE_INTERVAL * (rephases + 1);
+    }
+
+private:
+    void copyAssigned(const std::vector<int8_t>& values) {
+        for (size_t var = 1; var < values.size(); var++) {
+            if (values[var] != VALUE_UNASSIGNED) saved[var] = values[var];
+        }
+    }
+};
+
+#endif
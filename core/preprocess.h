@@ -0,0 +1,660 @@
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include "get_time.h"
+#include "propagator.h"
+#include "reconstruction.h"
+#include "subsume.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define DEFAULT_PREPROCESS "subsume,equiv,probe,subsume,bve,bce"
+
+#define BVE_OCCURRENCE_LIMIT 10  // Variables occurring more often than this in both polarities are not tried
+#define BVE_RESOLVENT_LIMIT 16   // A longer resolvent blocks the elimination
+#define BVE_ROUNDS 5             // Passes over the variables while some elimination succeeds
+#define PROBE_PROPAGATION_LIMIT 10000000 // Propagations the probing pass may spend
+#define BCE_OCCURRENCE_LIMIT 100 // Literals whose negation occurs more often than this are not tried as blocking
+
+// Simplification of the formula before search.
+// The formula is copied into a clause arena with one occurrence list per literal. Root-level units
+// are propagated away, subsumed clauses are dropped and clauses are strengthened by self-subsuming
+// resolution, failed literal probing fixes the literals whose negation propagates to a conflict or
+// that both polarities of a variable imply, equivalent literals found in the binary clauses are
+// replaced by one representative, bounded variable elimination replaces the clauses of a variable by
+// all their non-tautological resolvents whenever that does not add clauses, and blocked clauses are
+// dropped. Every clause removed on the way is recorded on the reconstruction stack, so the solvers
+// search the smaller formula and the model they find is extended back to the original variables
+// before it is printed.
+class Preprocessor {
+public:
+    int numVariables;
+    ClauseArena clauses;                       // Removed clauses are flagged CLAUSE_FLAG_DELETED
+    std::vector<std::vector<ClauseRef>> occurs; // Per literal (litIndex), may still list removed clauses
+    Assignment fixed;                          // Root-level units
+    std::vector<int> units;                    // Fixed literals not propagated yet
+    std::vector<char> eliminated;              // Per variable, eliminated or substituted
+    ReconstructionStack& stack;
+    bool unsat;
+    std::vector<int> mark;                     // Per variable, literal seen in the clause being built
+    std::vector<int> resolvent;                // Scratch
+    std::vector<uint64_t> signatures;          // Per clause, filled by subsumeClauses
+
+    // Stats
+    size_t originalClauses;
+    size_t fixedVariables;
+    size_t eliminatedVariables;
+    size_t subsumedClauses;
+    size_t strengthenedLiterals;
+    size_t probedLiterals;
+    size_t failedLiterals;
+    size_t hyperBinaries;
+    size_t substitutedVariables;
+    size_t blockedClauses;
+    double time;
+
+    Preprocessor(const ClauseArena& formula, int numVars, ReconstructionStack& s)
+        : numVariables(numVars), occurs(2 * (numVars + 1)), fixed(numVars), eliminated(numVars + 1, 0), stack(s),
+          unsat(false), mark(numVars + 1, 0), originalClauses(formula.size()), fixedVariables(0),
+          eliminatedVariables(0), subsumedClauses(0), strengthenedLiterals(0), probedLiterals(0), failedLiterals(0),
+          hyperBinaries(0), substitutedVariables(0), blockedClauses(0), time(0.0) {
+        clauses.reserve(formula.size(), formula.literals.size());
+        std::vector<int> clause;
+        for (const auto& c : formula) {
+            clause.assign(c.begin(), c.end());
+            addClause(clause);
+        }
+        propagate();
+    }
+
+    bool removed(ClauseRef cref) const { return clauses.headers[cref].flags & CLAUSE_FLAG_DELETED; }
+
+    void removeClause(ClauseRef cref) { clauses.headers[cref].flags |= CLAUSE_FLAG_DELETED; }
+
+    // Add a clause to the formula, dropping duplicate and fixed-false literals. Returns false if the clause
+    // is satisfied or a tautology and was not added.
+    bool addClause(std::vector<int>& clause) {
+        size_t j = 0;
+        bool keep = true;
+        for (int lit : clause) {
+            int8_t val = fixed.litValue(lit);
+            int& m = mark[litVar(lit)];
+            if (val == VALUE_TRUE || m == -lit) keep = false;
+            if (val != VALUE_UNASSIGNED || m == lit) continue;
+            m = lit;
+            clause[j++] = lit;
+        }
+        clause.resize(j);
+        for (int lit : clause) mark[litVar(lit)] = 0;
+        if (!keep) return false;
+        if (clause.empty()) unsat = true;
+        if (clause.size() == 1) {
+            fix(clause[0]);
+            return true;
+        }
+        ClauseRef cref = clauses.addClause(clause);
+        for (int lit : clause) occurs[litIndex(lit)].push_back(cref);
+        return true;
+    }
+
+    // Fix lit at the root, it is recorded as a unit clause witnessing itself
+    void fix(int lit) {
+        int8_t val = fixed.litValue(lit);
+        if (val == VALUE_TRUE) return;
+        if (val == VALUE_FALSE) {
+            unsat = true;
+            return;
+        }
+        fixed.assignLit(lit);
+        stack.push(lit, &lit, &lit + 1);
+        units.push_back(lit);
+        fixedVariables++;
+    }
+
+    // Remove the clauses satisfied by the fixed literals and the false literals from the others
+    void propagate() {
+        while (!units.empty() && !unsat) {
+            int lit = units.back();
+            units.pop_back();
+            for (ClauseRef cref : occurs[litIndex(lit)]) removeClause(cref);
+            occurs[litIndex(lit)].clear();
+            for (ClauseRef cref : occurs[litIndex(-lit)]) {
+                if (removed(cref)) continue;
+                int* lits = clauses.lits(cref);
+                uint32_t size = clauses.clauseSize(cref);
+                uint32_t j = 0;
+                for (uint32_t k = 0; k < size; k++) {
+                    if (lits[k] != -lit) lits[j++] = lits[k];
+                }
+                clauses.headers[cref].size = j;
+                if (j == 0) {
+                    unsat = true;
+                } else if (j == 1) {
+                    removeClause(cref);
+                    fix(lits[0]);
+                }
+            }
+            occurs[litIndex(-lit)].clear();
+        }
+    }
+
+    // Drop the removed clauses from the occurrence list of lit, returns the number left
+    size_t liveOccurrences(int lit) {
+        std::vector<ClauseRef>& list = occurs[litIndex(lit)];
+        size_t j = 0;
+        for (ClauseRef cref : list) {
+            if (!removed(cref)) list[j++] = cref;
+        }
+        list.resize(j);
+        return j;
+    }
+
+    // Resolve a clause containing var with one containing -var into resolvent, returns false for a tautology
+    bool resolve(ClauseRef pos, ClauseRef neg, int var) {
+        resolvent.clear();
+        bool tautology = false;
+        for (int lit : clauses[pos]) {
+            if (lit == var) continue;
+            mark[litVar(lit)] = lit;
+            resolvent.push_back(lit);
+        }
+        for (int lit : clauses[neg]) {
+            if (lit == -var) continue;
+            int m = mark[litVar(lit)];
+            if (m == -lit) {
+                tautology = true;
+                break;
+            }
+            if (m != lit) resolvent.push_back(lit);
+        }
+        for (int lit : clauses[pos]) mark[litVar(lit)] = 0;
+        return !tautology;
+    }
+
+    // Replace the clauses of var by their resolvents if there are no more of them than clauses removed
+    // and none is too long. Returns true if var was eliminated.
+    bool eliminate(int var) {
+        if (fixed.isAssigned(var) || eliminated[var]) return false;
+        size_t numPos = liveOccurrences(var), numNeg = liveOccurrences(-var);
+        if (numPos > BVE_OCCURRENCE_LIMIT && numNeg > BVE_OCCURRENCE_LIMIT) return false;
+        const std::vector<ClauseRef>& pos = occurs[litIndex(var)];
+        const std::vector<ClauseRef>& neg = occurs[litIndex(-var)];
+
+        // Count the resolvents first, giving up as soon as the bounds are exceeded
+        size_t limit = numPos + numNeg, count = 0;
+        for (ClauseRef p : pos) {
+            for (ClauseRef n : neg) {
+                if (!resolve(p, n, var)) continue;
+                if (++count > limit || resolvent.size() > BVE_RESOLVENT_LIMIT) return false;
+            }
+        }
+
+        // The clauses go on the reconstruction stack, the negative ones last so they are undone first
+        std::vector<ClauseRef> oldPos(pos), oldNeg(neg);
+        for (ClauseRef p : oldPos) {
+            stack.push(var, clauses.lits(p), clauses.lits(p) + clauses.clauseSize(p));
+            removeClause(p);
+        }
+        for (ClauseRef n : oldNeg) {
+            stack.push(-var, clauses.lits(n), clauses.lits(n) + clauses.clauseSize(n));
+            removeClause(n);
+        }
+        occurs[litIndex(var)].clear();
+        occurs[litIndex(-var)].clear();
+        eliminated[var] = 1;
+        eliminatedVariables++;
+
+        for (ClauseRef p : oldPos) {
+            for (ClauseRef n : oldNeg) {
+                if (resolve(p, n, var)) addClause(resolvent);
+            }
+        }
+        propagate();
+        return true;
+    }
+
+    // Remove lit from clause cref and cref from the occurrence list of lit
+    void strengthen(ClauseRef cref, int lit) {
+        int* lits = clauses.lits(cref);
+        uint32_t size = clauses.clauseSize(cref);
+        uint32_t j = 0;
+        for (uint32_t k = 0; k < size; k++) {
+            if (lits[k] != lit) lits[j++] = lits[k];
+        }
+        clauses.headers[cref].size = j;
+        std::vector<ClauseRef>& list = occurs[litIndex(lit)];
+        list.erase(std::find(list.begin(), list.end(), cref));
+        signatures[cref] = clauseSignature(lits, j);
+        strengthenedLiterals++;
+        if (j == 1) {
+            removeClause(cref);
+            fix(lits[0]);
+        }
+    }
+
+    // Backward subsumption: every clause, shortest first, removes the clauses it subsumes and strengthens
+    // those it subsumes with one literal negated. A strengthened clause is tried again as a subsumer.
+    void subsumeClauses() {
+        signatures.resize(clauses.size());
+        std::vector<std::pair<uint32_t, ClauseRef>> bySize;
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (removed(cref)) continue;
+            signatures[cref] = clauseSignature(clauses.lits(cref), clauses.clauseSize(cref));
+            bySize.push_back(std::make_pair(clauses.clauseSize(cref), cref));
+        }
+        std::sort(bySize.begin(), bySize.end());
+        std::vector<ClauseRef> queue;
+        for (const std::pair<uint32_t, ClauseRef>& c : bySize) queue.push_back(c.second);
+
+        std::vector<ClauseRef> candidates;
+        for (size_t q = 0; q < queue.size() && !unsat; q++) {
+            ClauseRef c = queue[q];
+            if (removed(c)) continue;
+            const int* lits = clauses.lits(c);
+            uint32_t size = clauses.clauseSize(c);
+
+            // Every clause c subsumes, even with one literal negated, contains its rarest variable
+            int best = lits[0];
+            size_t bestCount = SIZE_MAX;
+            for (uint32_t k = 0; k < size; k++) {
+                size_t count = liveOccurrences(lits[k]) + liveOccurrences(-lits[k]);
+                if (count < bestCount) {
+                    best = lits[k];
+                    bestCount = count;
+                }
+            }
+            candidates.assign(occurs[litIndex(best)].begin(), occurs[litIndex(best)].end());
+            candidates.insert(candidates.end(), occurs[litIndex(-best)].begin(), occurs[litIndex(-best)].end());
+
+            for (ClauseRef d : candidates) {
+                if (d == c || removed(d) || removed(c) || clauses.clauseSize(d) < clauses.clauseSize(c)) continue;
+                if (signatures[c] & ~signatures[d]) continue;
+                int result = subsumes(clauses.lits(c), clauses.clauseSize(c), clauses.lits(d), clauses.clauseSize(d), mark);
+                if (result == 0) {
+                    removeClause(d);
+                    subsumedClauses++;
+                } else if (result != SUBSUME_FAILED) {
+                    strengthen(d, -result);
+                    queue.push_back(d);
+                }
+            }
+            propagate();
+        }
+    }
+
+    // Assert lit at level 0 of the probing engine and fix everything it propagates, from rootTrail on
+    void probeFix(Propagator& engine, int lit, size_t& rootTrail) {
+        if (!engine.enqueue(lit) || engine.propagate() != CLAUSE_REF_UNDEF) {
+            unsat = true;
+            return;
+        }
+        for (; rootTrail < engine.trail.size(); rootTrail++) fix(engine.trail[rootTrail]);
+    }
+
+    // Failed literal probing on a propagation engine over the live clauses. Every literal whose negation
+    // occurs in a binary clause (otherwise it cannot propagate anything) is assigned at level 1. A conflict
+    // fixes its negation, and the literals implied by both polarities of a variable are fixed. Each literal
+    // implied through a longer clause adds the hyper-binary resolvent (-probe | implied), so that binary
+    // clauses alone reach it from then on.
+    void probeLiterals() {
+        if (unsat) return;
+        ClauseArena live;
+        emit(live);
+        Propagator engine(live, numVariables);
+        std::vector<char> inBinary(2 * (numVariables + 1), 0);
+        for (ClauseRef cref = 0; cref < live.size(); cref++) {
+            if (live.clauseSize(cref) != 2) continue;
+            inBinary[litIndex(live.lits(cref)[0])] = 1;
+            inBinary[litIndex(live.lits(cref)[1])] = 1;
+        }
+
+        std::vector<int> impliedBy(2 * (numVariables + 1), 0); // Per literal, variable whose positive probe implied it
+        std::vector<int> implied, longImplied, forced, binary(2);
+        size_t rootTrail = engine.trail.size();
+        for (int var = 1; var <= numVariables && !unsat; var++) {
+            if (engine.propagations > PROBE_PROPAGATION_LIMIT) break;
+            if (fixed.isAssigned(var) || eliminated[var]) continue;
+            bool positiveProbed = false;
+            for (int probe : {var, -var}) {
+                if (!inBinary[litIndex(-probe)] || engine.assignment.isAssigned(var)) continue;
+                probedLiterals++;
+                engine.newDecisionLevel();
+                engine.enqueue(probe);
+                ClauseRef confl = engine.propagate();
+                implied.clear();
+                longImplied.clear();
+                for (size_t i = engine.trailLim[0] + 1; i < engine.trail.size() && confl == CLAUSE_REF_UNDEF; i++) {
+                    int lit = engine.trail[i];
+                    implied.push_back(lit);
+                    ClauseRef r = engine.reason[litVar(lit)];
+                    if (r != CLAUSE_REF_UNDEF && engine.clauses.clauseSize(r) > 2) longImplied.push_back(lit);
+                }
+                engine.cancelUntil(0);
+                if (confl != CLAUSE_REF_UNDEF) {
+                    failedLiterals++;
+                    probeFix(engine, -probe, rootTrail);
+                    break;
+                }
+
+                for (int lit : longImplied) {
+                    binary[0] = -probe;
+                    binary[1] = lit;
+                    engine.addClause(binary, 0);
+                    addClause(binary);
+                    hyperBinaries++;
+                }
+                forced.clear();
+                for (int lit : implied) {
+                    if (probe == var) {
+                        impliedBy[litIndex(lit)] = var;
+                    } else if (positiveProbed && impliedBy[litIndex(lit)] == var) {
+                        forced.push_back(lit);
+                    }
+                }
+                positiveProbed = true;
+                for (int lit : forced) {
+                    if (!unsat) probeFix(engine, lit, rootTrail);
+                }
+            }
+        }
+        propagate();
+    }
+
+    // Equivalent literal substitution. The binary clauses form an implication graph over the literals
+    // (a | b gives -a -> b and -b -> a), in which the literals of a strongly connected component are all
+    // equivalent. Tarjan's algorithm finds the components, and each one is replaced throughout the formula
+    // by its literal of lowest variable; a component holding both polarities of a variable refutes the
+    // formula. A substituted variable leaves the two binary clauses of its equivalence on the stack.
+    void substituteEquivalences() {
+        if (unsat) return;
+        uint32_t numLits = 2 * (numVariables + 1);
+
+        // Implication graph in compressed rows, indexed by litIndex
+        std::vector<uint32_t> start(numLits + 1, 0);
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (removed(cref) || clauses.clauseSize(cref) != 2) continue;
+            const int* lits = clauses.lits(cref);
+            start[litIndex(-lits[0]) + 1]++;
+            start[litIndex(-lits[1]) + 1]++;
+        }
+        for (uint32_t i = 0; i < numLits; i++) start[i + 1] += start[i];
+        std::vector<int> edges(start[numLits]);
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (removed(cref) || clauses.clauseSize(cref) != 2) continue;
+            const int* lits = clauses.lits(cref);
+            edges[fill[litIndex(-lits[0])]++] = lits[1];
+            edges[fill[litIndex(-lits[1])]++] = lits[0];
+        }
+
+        // Tarjan's algorithm with an explicit stack of (node, next edge)
+        std::vector<int> index(numLits, -1), low(numLits, 0);
+        std::vector<char> onStack(numLits, 0);
+        std::vector<uint32_t> component;
+        std::vector<std::pair<uint32_t, uint32_t>> path;
+        std::vector<int> repr(numLits, 0); // Representative of each literal in a component of two or more
+        int counter = 0;
+        for (uint32_t root = 2; root < numLits && !unsat; root++) {
+            if (index[root] >= 0 || start[root] == start[root + 1]) continue;
+            index[root] = low[root] = counter++;
+            component.push_back(root);
+            onStack[root] = 1;
+            path.push_back(std::make_pair(root, start[root]));
+            while (!path.empty() && !unsat) {
+                uint32_t node = path.back().first;
+                if (path.back().second < start[node + 1]) {
+                    uint32_t next = litIndex(edges[path.back().second++]);
+                    if (index[next] < 0) {
+                        index[next] = low[next] = counter++;
+                        component.push_back(next);
+                        onStack[next] = 1;
+                        path.push_back(std::make_pair(next, start[next]));
+                    } else if (onStack[next]) {
+                        low[node] = std::min(low[node], index[next]);
+                    }
+                    continue;
+                }
+                path.pop_back();
+                if (!path.empty()) low[path.back().first] = std::min(low[path.back().first], low[node]);
+                if (low[node] != index[node]) continue;
+
+                // node is the root of a component, which sits on top of the stack
+                size_t first = component.size();
+                do {
+                    first--;
+                } while (component[first] != node);
+                int representative = 0;
+                for (size_t k = first; k < component.size(); k++) {
+                    int lit = indexLit(component[k]);
+                    onStack[component[k]] = 0;
+                    if (mark[litVar(lit)] == -lit) unsat = true;
+                    mark[litVar(lit)] = lit;
+                    if (representative == 0 || litVar(lit) < litVar(representative)) representative = lit;
+                }
+                for (size_t k = first; k < component.size(); k++) {
+                    mark[litVar(indexLit(component[k]))] = 0;
+                    if (component.size() - first > 1) repr[component[k]] = representative;
+                }
+                component.resize(first);
+            }
+            path.clear();
+        }
+        if (unsat) return;
+
+        // Both polarities of a variable have mirrored components, so substituting var by its representative
+        // also substitutes -var by the negation
+        std::vector<int> substituted;
+        for (int var = 1; var <= numVariables; var++) {
+            int r = repr[litIndex(var)];
+            if (r == 0 || r == var) continue;
+            stack.push(var, std::vector<int>{var, -r});
+            stack.push(-var, std::vector<int>{-var, r});
+            eliminated[var] = 1;
+            substitutedVariables++;
+            substituted.push_back(var);
+        }
+        if (substituted.empty()) return;
+
+        std::vector<int> clause;
+        ClauseRef end = clauses.size(); // Rewritten clauses are added past it
+        for (ClauseRef cref = 0; cref < end && !unsat; cref++) {
+            if (removed(cref)) continue;
+            const int* lits = clauses.lits(cref);
+            uint32_t size = clauses.clauseSize(cref);
+            bool touched = false;
+            for (uint32_t k = 0; k < size && !touched; k++) touched = eliminated[litVar(lits[k])];
+            if (!touched) continue;
+            clause.clear();
+            for (uint32_t k = 0; k < size; k++) {
+                int r = repr[litIndex(lits[k])];
+                clause.push_back(r == 0 ? lits[k] : r);
+            }
+            removeClause(cref);
+            addClause(clause);
+        }
+        for (int var : substituted) {
+            occurs[litIndex(var)].clear();
+            occurs[litIndex(-var)].clear();
+        }
+        propagate();
+    }
+
+    // Bounded variable elimination, cheapest variables (fewest resolution pairs) first
+    void eliminateVariables() {
+        std::vector<std::pair<size_t, int>> order;
+        for (int round = 0; round < BVE_ROUNDS && !unsat; round++) {
+            order.clear();
+            for (int var = 1; var <= numVariables; var++) {
+                if (fixed.isAssigned(var) || eliminated[var]) continue;
+                order.push_back(std::make_pair(liveOccurrences(var) * liveOccurrences(-var), var));
+            }
+            std::sort(order.begin(), order.end());
+            size_t before = eliminatedVariables;
+            for (const std::pair<size_t, int>& candidate : order) {
+                if (unsat) break;
+                eliminate(candidate.second);
+            }
+            if (eliminatedVariables == before) break;
+        }
+    }
+
+    // Whether clause cref is blocked on its literal lit: every resolvent on lit is a tautology
+    bool blocked(ClauseRef cref, int lit) {
+        const int* lits = clauses.lits(cref);
+        uint32_t size = clauses.clauseSize(cref);
+        for (uint32_t k = 0; k < size; k++) mark[litVar(lits[k])] = lits[k];
+        bool result = true;
+        for (ClauseRef d : occurs[litIndex(-lit)]) {
+            if (removed(d)) continue;
+            const int* other = clauses.lits(d);
+            uint32_t otherSize = clauses.clauseSize(d);
+            bool tautology = false;
+            for (uint32_t k = 0; k < otherSize && !tautology; k++) {
+                tautology = other[k] != -lit && mark[litVar(other[k])] == -other[k];
+            }
+            if (!tautology) {
+                result = false;
+                break;
+            }
+        }
+        for (uint32_t k = 0; k < size; k++) mark[litVar(lits[k])] = 0;
+        return result;
+    }
+
+    // Blocked clause elimination. A clause blocked on one of its literals goes on the stack with that
+    // literal as witness: a model that falsifies it stays a model of the rest once the witness is made
+    // true. Dropping a clause can block the clauses containing the negation of its other literals, so
+    // those literals are tried again.
+    void eliminateBlocked() {
+        if (unsat) return;
+        std::vector<int> pending;
+        std::vector<char> queued(2 * (numVariables + 1), 0);
+        for (int var = numVariables; var >= 1; var--) {
+            if (fixed.isAssigned(var) || eliminated[var]) continue;
+            for (int lit : {-var, var}) {
+                pending.push_back(lit);
+                queued[litIndex(lit)] = 1;
+            }
+        }
+
+        std::vector<ClauseRef> candidates;
+        while (!pending.empty()) {
+            int lit = pending.back();
+            pending.pop_back();
+            queued[litIndex(lit)] = 0;
+            if (liveOccurrences(-lit) > BCE_OCCURRENCE_LIMIT || liveOccurrences(lit) == 0) continue;
+            candidates.assign(occurs[litIndex(lit)].begin(), occurs[litIndex(lit)].end());
+            for (ClauseRef c : candidates) {
+                if (removed(c) || !blocked(c, lit)) continue;
+                const int* lits = clauses.lits(c);
+                uint32_t size = clauses.clauseSize(c);
+                stack.push(lit, lits, lits + size);
+                removeClause(c);
+                blockedClauses++;
+                for (uint32_t k = 0; k < size; k++) {
+                    if (lits[k] == lit || queued[litIndex(-lits[k])]) continue;
+                    pending.push_back(-lits[k]);
+                    queued[litIndex(-lits[k])] = 1;
+                }
+            }
+        }
+    }
+
+    // Run the passes named in a comma-separated list, returns false on an unknown name
+    bool run(const std::string& passes) {
+        timer t;
+        t.start();
+        std::istringstream list(passes);
+        std::string pass;
+        while (std::getline(list, pass, ',')) {
+            if (pass == "none" || pass.empty()) continue;
+            if (unsat) break;
+            if (pass == "bve") {
+                eliminateVariables();
+            } else if (pass == "subsume") {
+                subsumeClauses();
+            } else if (pass == "probe") {
+                probeLiterals();
+            } else if (pass == "equiv") {
+                substituteEquivalences();
+            } else if (pass == "bce") {
+                eliminateBlocked();
+            } else {
+                return false;
+            }
+        }
+        time = t.stop();
+        return true;
+    }
+
+    size_t numClauses() const {
+        size_t count = 0;
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (!removed(cref)) count++;
+        }
+        return count;
+    }
+
+    // The simplified formula, a single empty clause if it is unsatisfiable
+    void emit(ClauseArena& out) const {
+        out = ClauseArena();
+        if (unsat) {
+            out.addClause(std::vector<int>());
+            return;
+        }
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (!removed(cref)) out.addClause(clauses.lits(cref), clauses.lits(cref) + clauses.clauseSize(cref));
+        }
+    }
+
+    void printStats() const {
+        std::cout << "Preprocessing: " << originalClauses << " clauses -> " << (unsat ? 0 : numClauses())
+                  << ", fixed variables: " << fixedVariables << ", eliminated variables: " << eliminatedVariables
+                  << ", subsumed clauses: " << subsumedClauses << ", strengthened literals: " << strengthenedLiterals
+                  << ", failed literals: " << failedLiterals << ", hyper-binary resolvents: " << hyperBinaries
+                  << ", substituted variables: " << substitutedVariables << ", blocked clauses: " << blockedClauses
+                  << (unsat ? ", formula refuted" : "") << ", time: " << time << " seconds\n";
+    }
+};
+
+// Check a comma-separated list of preprocessing passes
+inline bool validPreprocess(const std::string& passes) {
+    ClauseArena empty;
+    ReconstructionStack stack;
+    Preprocessor preprocessor(empty, 0, stack);
+    return preprocessor.run(passes);
+}
+
+// Simplify formula in place with the given passes, recording what is needed to extend models in stack
+inline void preprocess(ClauseArena& formula, int numVariables, const std::string& passes, ReconstructionStack& stack,
+                       bool report = true) {
+    Preprocessor preprocessor(formula, numVariables, stack);
+    preprocessor.run(passes);
+    preprocessor.emit(formula);
+    if (report) preprocessor.printStats();
+}
+
+// Up to count variables to split the search on, chosen among those still occurring in the simplified
+// formula, most frequent first. Fewer come back when fewer remain, none once every clause is gone.
+inline std::vector<int> splitVariables(const ClauseArena& formula, int numVariables, int count) {
+    std::vector<size_t> occurrences(numVariables + 1, 0);
+    for (const auto& clause : formula) {
+        for (int lit : clause) occurrences[litVar(lit)]++;
+    }
+    std::vector<int> vars;
+    for (int var = 1; var <= numVariables; var++) {
+        if (occurrences[var] > 0) vars.push_back(var);
+    }
+    std::stable_sort(vars.begin(), vars.end(), [&occurrences](int a, int b) { return occurrences[a] > occurrences[b]; });
+    if ((int)vars.size() > count) vars.resize(count);
+    return vars;
+}
+
+#endif
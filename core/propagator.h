@@ -0,0 +1,265 @@
+#ifndef PROPAGATOR_H
+#define PROPAGATOR_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include <cstdint>
+#include <vector>
+
+struct Watcher {
+    ClauseRef cref;
+    int blocker; // Some other literal of the clause, if it is true the clause needs no visit
+};
+
+// Two-watched-literal unit propagation engine.
+// Every clause of size >= 2 watches its first two literals. When a literal becomes false only the
+// clauses watching it are visited, and each either finds a replacement watch, becomes unit, or
+// reports a conflict. Assignments are recorded on a trail which doubles as the propagation queue.
+// Every assigned variable remembers its decision level and the clause that implied it, which is the
+// implication graph used by conflict analysis; an implied literal always sits at position 0 of its reason.
+// The trail need not be sorted by level: a literal implied by literals of lower levels only is assigned
+// at the highest of them, and survives backtracks to that level (chronological backtracking).
+class Propagator {
+public:
+    ClauseArena clauses;   // Private copy of the formula, watched literals are kept at positions 0 and 1
+    Assignment assignment;
+    std::vector<int> trail; // Assigned literals in assignment order
+    std::vector<size_t> trailLim; // Trail size at the start of each decision level
+    std::vector<ClauseRef> reason; // Per variable, clause that implied it (CLAUSE_REF_UNDEF for decisions and units)
+    std::vector<int> level;        // Per variable, decision level it was assigned at
+    std::vector<uint64_t> levelStamp; // Per decision level, last LBD computation that counted it
+    uint64_t stamp;
+    size_t qhead;           // Next trail position to propagate
+    std::vector<std::vector<Watcher>> watches; // Indexed by litIndex, clauses to visit when the literal becomes false
+    std::vector<int> units; // Literals of the unit clauses, asserted again on every reset
+    bool inconsistent;      // Formula has an empty clause or contradicting units
+    uint64_t propagations;  // Number of literals propagated so far
+
+    Propagator(const ClauseArena& formula, int numVariables)
+        : clauses(formula), assignment(numVariables), reason(numVariables + 1, CLAUSE_REF_UNDEF),
+          level(numVariables + 1, 0), levelStamp(numVariables + 2, 0), stamp(0), qhead(0),
+          watches(2 * (numVariables + 1)), inconsistent(false), propagations(0) {
+        trail.reserve(numVariables);
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            uint32_t size = clauses.clauseSize(cref);
+            if (size == 0) {
+                inconsistent = true;
+            } else if (size == 1) {
+                units.push_back(clauses.lits(cref)[0]);
+            } else {
+                attachClause(cref);
+            }
+        }
+        reset();
+    }
+
+    int numVariables() const { return assignment.numVariables(); }
+
+    void attachClause(ClauseRef cref) {
+        const int* lits = clauses.lits(cref);
+        watches[litIndex(lits[0])].push_back(Watcher{cref, lits[1]});
+        watches[litIndex(lits[1])].push_back(Watcher{cref, lits[0]});
+    }
+
+    // Stop watching a clause, its watched literals must still be at positions 0 and 1
+    void detachClause(ClauseRef cref) {
+        const int* lits = clauses.lits(cref);
+        for (int k = 0; k < 2; k++) {
+            std::vector<Watcher>& ws = watches[litIndex(lits[k])];
+            for (size_t i = 0; i < ws.size(); i++) {
+                if (ws[i].cref == cref) {
+                    ws[i] = ws.back();
+                    ws.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+
+    // Add a clause to the private copy and watch it, the two literals to watch must come first
+    ClauseRef addClause(const std::vector<int>& lits, uint32_t flags) {
+        ClauseRef cref = clauses.addClause(lits.data(), lits.data() + lits.size(), flags);
+        if (lits.size() >= 2) attachClause(cref);
+        return cref;
+    }
+
+    // Drop the clauses flagged CLAUSE_FLAG_DELETED and compact the private copy, then point the watches
+    // and the reasons at the new references. A deleted clause must not be the reason of an assigned literal.
+    void collectGarbage(std::vector<ClauseRef>& remap) {
+        clauses.compact(remap);
+        for (std::vector<Watcher>& ws : watches) {
+            size_t j = 0;
+            for (size_t i = 0; i < ws.size(); i++) {
+                ClauseRef cref = remap[ws[i].cref];
+                if (cref == CLAUSE_REF_UNDEF) continue;
+                ws[j] = ws[i];
+                ws[j++].cref = cref;
+            }
+            ws.resize(j);
+        }
+        for (int lit : trail) {
+            ClauseRef& r = reason[litVar(lit)];
+            if (r != CLAUSE_REF_UNDEF) r = remap[r];
+        }
+    }
+
+    // Make lit true at the given level (the current one by default) and queue it for propagation,
+    // returns false if lit is already false
+    bool enqueue(int lit, ClauseRef from = CLAUSE_REF_UNDEF, int lvl = -1) {
+        int8_t val = assignment.litValue(lit);
+        if (val != VALUE_UNASSIGNED) return val == VALUE_TRUE;
+        int var = litVar(lit);
+        assignment.assignLit(lit);
+        reason[var] = from;
+        level[var] = lvl < 0 ? decisionLevel() : lvl;
+        trail.push_back(lit);
+        return true;
+    }
+
+    // Propagate every queued literal to fixpoint, returns the conflicting clause or CLAUSE_REF_UNDEF
+    ClauseRef propagate() {
+        while (qhead < trail.size()) {
+            int falseLit = -trail[qhead++];
+            propagations++;
+            std::vector<Watcher>& ws = watches[litIndex(falseLit)];
+            size_t i = 0, j = 0, n = ws.size();
+            while (i < n) {
+                Watcher w = ws[i++];
+                // Clause already satisfied by its blocker
+                if (assignment.litValue(w.blocker) == VALUE_TRUE) {
+                    ws[j++] = w;
+                    continue;
+                }
+
+                // Make sure the false literal sits at position 1
+                int* lits = clauses.lits(w.cref);
+                if (lits[0] == falseLit) {
+                    lits[0] = lits[1];
+                    lits[1] = falseLit;
+                }
+                int first = lits[0];
+                Watcher kept{w.cref, first};
+                if (first != w.blocker && assignment.litValue(first) == VALUE_TRUE) {
+                    ws[j++] = kept;
+                    continue;
+                }
+
+                // Look for a new literal to watch
+                uint32_t size = clauses.clauseSize(w.cref);
+                bool moved = false;
+                for (uint32_t k = 2; k < size; k++) {
+                    if (assignment.litValue(lits[k]) != VALUE_FALSE) {
+                        lits[1] = lits[k];
+                        lits[k] = falseLit;
+                        watches[litIndex(lits[1])].push_back(kept);
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) continue;
+
+                // Clause is unit or conflicting
+                ws[j++] = kept;
+                if (assignment.litValue(first) == VALUE_FALSE) {
+                    while (i < n) ws[j++] = ws[i++];
+                    ws.resize(j);
+                    qhead = trail.size();
+                    return w.cref;
+                }
+                // Propagating a literal from below the current level, the clause is unit at the highest
+                // level of its false literals, which takes the second watch so a backtrack frees it
+                int lvl = decisionLevel();
+                if (level[litVar(falseLit)] < lvl) {
+                    lvl = level[litVar(falseLit)];
+                    uint32_t maxK = 1;
+                    for (uint32_t k = 2; k < size; k++) {
+                        if (level[litVar(lits[k])] > lvl) {
+                            lvl = level[litVar(lits[k])];
+                            maxK = k;
+                        }
+                    }
+                    if (maxK != 1) {
+                        lits[1] = lits[maxK];
+                        lits[maxK] = falseLit;
+                        watches[litIndex(lits[1])].push_back(kept);
+                        j--;
+                    }
+                }
+                enqueue(first, w.cref, lvl);
+            }
+            ws.resize(j);
+        }
+        return CLAUSE_REF_UNDEF;
+    }
+
+    int decisionLevel() const { return (int)trailLim.size(); }
+
+    // Literal block distance: number of distinct decision levels among the given assigned literals
+    uint32_t computeLBD(const int* lits, uint32_t size) {
+        stamp++;
+        uint32_t lbd = 0;
+        for (uint32_t i = 0; i < size; i++) {
+            int lvl = level[litVar(lits[i])];
+            if (levelStamp[lvl] != stamp) {
+                levelStamp[lvl] = stamp;
+                lbd++;
+            }
+        }
+        return lbd;
+    }
+
+    // Open a new decision level, the next enqueued literal is its decision
+    void newDecisionLevel() { trailLim.push_back(trail.size()); }
+
+    // Undo every assignment made after the trail had the given size
+    void backtrackTo(size_t trailSize) {
+        while (trail.size() > trailSize) {
+            assignment.unassign(litVar(trail.back()));
+            trail.pop_back();
+        }
+        if (qhead > trailSize) qhead = trailSize;
+        while (!trailLim.empty() && trailLim.back() > trailSize) {
+            trailLim.pop_back();
+        }
+    }
+
+    // Undo every decision level above the target. Literals above it on the trail but assigned at or
+    // below it are kept, in order, and propagated again.
+    void cancelUntil(int target) {
+        if (decisionLevel() <= target) return;
+        size_t start = trailLim[target], j = start;
+        for (size_t i = start; i < trail.size(); i++) {
+            int lit = trail[i];
+            if (level[litVar(lit)] <= target) {
+                trail[j++] = lit;
+            } else {
+                assignment.unassign(litVar(lit));
+            }
+        }
+        trail.resize(j);
+        if (qhead > start) qhead = start;
+        trailLim.resize(target);
+    }
+
+    // Clear the assignment and assert the unit clauses again, returns false if the formula is trivially unsatisfiable
+    bool reset() {
+        backtrackTo(0);
+        trailLim.clear();
+        for (int lit : units) {
+            if (!enqueue(lit)) inconsistent = true;
+        }
+        return !inconsistent;
+    }
+
+    // Replace the current assignment with a copy of the given one (nothing is propagated yet)
+    bool loadAssignment(const Assignment& other) {
+        if (!reset()) return false;
+        for (int var = 1; var <= other.numVariables(); var++) {
+            int8_t val = other.value(var);
+            if (val != VALUE_UNASSIGNED && !enqueue(val == VALUE_TRUE ? var : -var)) return false;
+        }
+        return true;
+    }
+};
+
+#endif
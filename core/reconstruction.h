@@ -0,0 +1,53 @@
+#ifndef RECONSTRUCTION_H
+#define RECONSTRUCTION_H
+
+#include "assignment.h"
+#include <cstdint>
+#include <vector>
+
+// Clauses removed by the preprocessor, each with a witness literal, in the order they were removed.
+// A model of the simplified formula becomes a model of the original one by walking the stack
+// backwards and making the witness true whenever its clause is not satisfied yet: a fixed literal
+// is a unit clause witnessing itself, an eliminated variable leaves its clauses with the variable
+// as witness, and so on.
+class ReconstructionStack {
+public:
+    std::vector<int> literals;  // Clauses one after the other, each starting with its witness
+    std::vector<size_t> starts; // Offset of each clause in literals
+
+    bool empty() const { return starts.empty(); }
+
+    size_t size() const { return starts.size(); }
+
+    // Record a removed clause, the witness must be one of its literals
+    void push(int witness, const int* begin, const int* end) {
+        starts.push_back(literals.size());
+        literals.push_back(witness);
+        for (const int* p = begin; p != end; p++) {
+            if (*p != witness) literals.push_back(*p);
+        }
+    }
+
+    void push(int witness, const std::vector<int>& clause) { push(witness, clause.data(), clause.data() + clause.size()); }
+
+    // Turn a model of the simplified formula into one of the original formula. Variables the model
+    // leaves unassigned are set to false first.
+    void extend(Assignment& assignment) const {
+        for (int var = 1; var <= assignment.numVariables(); var++) {
+            if (!assignment.isAssigned(var)) assignment.assignLit(-var);
+        }
+        for (size_t i = starts.size(); i-- > 0;) {
+            size_t begin = starts[i], end = i + 1 < starts.size() ? starts[i + 1] : literals.size();
+            bool satisfied = false;
+            for (size_t k = begin; k < end && !satisfied; k++) {
+                satisfied = assignment.litValue(literals[k]) == VALUE_TRUE;
+            }
+            if (satisfied) continue;
+            int witness = literals[begin];
+            assignment.unassign(litVar(witness));
+            assignment.assignLit(witness);
+        }
+    }
+};
+
+#endif
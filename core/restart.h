@@ -0,0 +1,125 @@
+#ifndef RESTART_H
+#define RESTART_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define DEFAULT_RESTART "luby"
+
+// Restart policy: decides after which conflicts the search drops back to the root.
+// Restarts keep everything the search learned (clauses, activities) and only undo the decisions,
+// so an early bad decision does not trap the search in a huge subtree.
+class RestartPolicy {
+public:
+    virtual ~RestartPolicy() {}
+
+    // A conflict was handled, lbd is the number of decision levels in its clause
+    virtual void onConflict(uint32_t lbd) = 0;
+
+    virtual bool shouldRestart() const = 0;
+
+    // The search has just restarted
+    virtual void onRestart() = 0;
+};
+
+// Never restart
+class NoRestart : public RestartPolicy {
+public:
+    void onConflict(uint32_t) override {}
+    bool shouldRestart() const override { return false; }
+    void onRestart() override {}
+};
+
+// Restart after unit * luby(i) conflicts, where luby is 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+class LubyRestart : public RestartPolicy {
+    uint64_t unit;
+    uint64_t index;
+    uint64_t limit;
+    uint64_t conflicts; // Since the last restart
+
+    static uint64_t luby(uint64_t i) {
+        // Find the finite subsequence that contains index i, and its size
+        uint64_t size = 1, seq = 0;
+        while (size < i + 1) {
+            seq++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != i) {
+            size = (size - 1) >> 1;
+            seq--;
+            i = i % size;
+        }
+        return 1ull << seq;
+    }
+
+public:
+    explicit LubyRestart(uint64_t u = 100) : unit(u), index(0), limit(u * luby(0)), conflicts(0) {}
+
+    void onConflict(uint32_t) override { conflicts++; }
+    bool shouldRestart() const override { return conflicts >= limit; }
+    void onRestart() override {
+        conflicts = 0;
+        limit = unit * luby(++index);
+    }
+};
+
+// Restart after first, first * factor, first * factor^2, ... conflicts
+class GeometricRestart : public RestartPolicy {
+    double limit;
+    double factor;
+    uint64_t conflicts; // Since the last restart
+
+public:
+    explicit GeometricRestart(double first = 100, double f = 1.5) : limit(first), factor(f), conflicts(0) {}
+
+    void onConflict(uint32_t) override { conflicts++; }
+    bool shouldRestart() const override { return conflicts >= limit; }
+    void onRestart() override {
+        conflicts = 0;
+        limit *= factor;
+    }
+};
+
+// Glucose-style dynamic restarts: a fast moving average of the learned clause LBDs is compared with
+// a slow one, and the search restarts when recent clauses are markedly worse than usual.
+class EMARestart : public RestartPolicy {
+    double fast;
+    double slow;
+    double fastAlpha;
+    double slowAlpha;
+    double margin;
+    uint64_t minConflicts; // Conflicts to wait after a restart before the averages are trusted again
+    uint64_t conflicts;    // Since the last restart
+    uint64_t total;
+
+public:
+    EMARestart(double fa = 1.0 / 32, double sa = 1.0 / 4096, double m = 1.25, uint64_t minC = 50)
+        : fast(0), slow(0), fastAlpha(fa), slowAlpha(sa), margin(m), minConflicts(minC), conflicts(0), total(0) {}
+
+    void onConflict(uint32_t lbd) override {
+        conflicts++;
+        // The first conflict seeds both averages
+        if (total++ == 0) {
+            fast = slow = lbd;
+            return;
+        }
+        fast += fastAlpha * (lbd - fast);
+        slow += slowAlpha * (lbd - slow);
+    }
+
+    bool shouldRestart() const override { return conflicts >= minConflicts && fast > margin * slow; }
+
+    void onRestart() override { conflicts = 0; }
+};
+
+// Build the restart policy named on the command line, nullptr if the name is unknown
+inline std::unique_ptr<RestartPolicy> makeRestartPolicy(const std::string& name) {
+    if (name == "none") return std::unique_ptr<RestartPolicy>(new NoRestart());
+    if (name == "luby") return std::unique_ptr<RestartPolicy>(new LubyRestart());
+    if (name == "geometric") return std::unique_ptr<RestartPolicy>(new GeometricRestart());
+    if (name == "ema") return std::unique_ptr<RestartPolicy>(new EMARestart());
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef SLS_H
+#define SLS_H
+
+#include "assignment.h"
+#include "clause_arena.h"
+#include "occurrences.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SLS_PROBSAT 0
+#define SLS_WALKSAT 1
+#define DEFAULT_SLS_RULE "probsat"
+
+#define PROBSAT_CB 2.38   // Polynomial break weight (eps + break)^-cb, tuned for 3-SAT
+#define PROBSAT_EPS 1.0
+#define WALKSAT_NOISE 0.567
+#define SLS_BREAK_TABLE 64 // Break values with a precomputed ProbSAT weight
+
+#define UNSAT_POS_NONE UINT32_MAX
+
+#define DEFAULT_SLS_INTERVAL "2000"  // Conflicts between local search bursts, 0 for none
+#define DEFAULT_SLS_FLIPS "20000"    // Flips per burst
+
+// Stochastic local search over complete assignments (ProbSAT / WalkSAT).
+// Every clause counts its true literals and keeps the XOR of their variables, which is the only true
+// variable whenever the count is one. From these, a flip updates the break count (clauses that would
+// become unsatisfied) and the make count (unsatisfied clauses that would become satisfied) of the
+// affected variables and the list of unsatisfied clauses in time proportional to the occurrences of
+// the flipped variable. It can find models, never prove unsatisfiability.
+class LocalSearch {
+public:
+    ClauseArena clauses;            // Private copy without duplicate literals and tautologies
+    OccurrenceLists occurs;
+    int numVariables;
+    bool hasEmptyClause;
+    std::vector<int8_t> value;      // Per variable, VALUE_TRUE or VALUE_FALSE
+    std::vector<uint32_t> trueCount; // Per clause
+    std::vector<int> trueXor;       // Per clause, XOR of the variables of its true literals
+    std::vector<ClauseRef> unsat;   // Unsatisfied clauses, in no order
+    std::vector<uint32_t> unsatPos; // Per clause, position in unsat or UNSAT_POS_NONE
+    std::vector<int> breakCount;    // Per variable
+    std::vector<int> makeCount;     // Per variable
+    std::vector<double> probTable;  // ProbSAT weight by break value
+    std::vector<double> weights;    // Scratch for ProbSAT sampling
+    std::vector<int8_t> bestValue;  // Values with the fewest unsatisfied clauses seen by the last solve
+    size_t bestUnsat;
+    uint64_t rngState;
+    uint64_t flips;
+    const std::atomic<bool>* stop;  // Set by another thread to abandon the search, may be null
+
+    LocalSearch(const ClauseArena& formula, int numVars, uint64_t seed = 1)
+        : clauses(cleanFormula(formula, numVars)), occurs(clauses, numVars), numVariables(numVars),
+          hasEmptyClause(false), value(numVars + 1, VALUE_TRUE), bestUnsat(SIZE_MAX), rngState(seed * 0x9E3779B97F4A7C15ull + 1),
+          flips(0), stop(nullptr) {
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            if (clauses.clauseSize(cref) == 0) hasEmptyClause = true;
+        }
+        probTable.resize(SLS_BREAK_TABLE);
+        for (int b = 0; b < SLS_BREAK_TABLE; b++) probTable[b] = std::pow(PROBSAT_EPS + b, -PROBSAT_CB);
+    }
+
+    // Drop duplicate literals and tautological clauses, which would break the XOR bookkeeping
+    static ClauseArena cleanFormula(const ClauseArena& formula, int numVars) {
+        ClauseArena cleaned;
+        cleaned.reserve(formula.size(), formula.literals.size());
+        std::vector<int> mark(numVars + 1, 0); // Literal last seen for each variable, per clause
+        std::vector<int> clause;
+        for (const auto& c : formula) {
+            clause.clear();
+            bool tautology = false;
+            for (int lit : c) {
+                int& m = mark[litVar(lit)];
+                if (m == lit) continue;
+                if (m == -lit) tautology = true;
+                m = lit;
+                clause.push_back(lit);
+            }
+            for (int lit : c) mark[litVar(lit)] = 0;
+            if (!tautology) cleaned.addClause(clause);
+        }
+        return cleaned;
+    }
+
+    // xorshift64*
+    uint64_t nextRandom() {
+        rngState ^= rngState >> 12;
+        rngState ^= rngState << 25;
+        rngState ^= rngState >> 27;
+        return rngState * 0x2545F4914F6CDD1Dull;
+    }
+
+    uint32_t randomBelow(uint32_t n) { return (uint32_t)((nextRandom() >> 32) * n >> 32); }
+
+    double randomUnit() { return (nextRandom() >> 11) * (1.0 / 9007199254740992.0); }
+
+    int litValue(int lit) const { return lit > 0 ? value[lit] : -value[-lit]; }
+
+    void addUnsat(ClauseRef cref) {
+        unsatPos[cref] = (uint32_t)unsat.size();
+        unsat.push_back(cref);
+    }
+
+    void removeUnsat(ClauseRef cref) {
+        ClauseRef last = unsat.back();
+        unsat[unsatPos[cref]] = last;
+        unsatPos[last] = unsatPos[cref];
+        unsat.pop_back();
+        unsatPos[cref] = UNSAT_POS_NONE;
+    }
+
+    // Start from the given values (random where phases is empty) and rebuild every counter
+    void initialize(const std::vector<int8_t>& phases) {
+        for (int var = 1; var <= numVariables; var++) {
+            if (!phases.empty() && phases[var] != VALUE_UNASSIGNED) {
+                value[var] = phases[var];
+            } else {
+                value[var] = (nextRandom() >> 63) ? VALUE_TRUE : VALUE_FALSE;
+            }
+        }
+        trueCount.assign(clauses.size(), 0);
+        trueXor.assign(clauses.size(), 0);
+        unsatPos.assign(clauses.size(), UNSAT_POS_NONE);
+        unsat.clear();
+        breakCount.assign(numVariables + 1, 0);
+        makeCount.assign(numVariables + 1, 0);
+        for (ClauseRef cref = 0; cref < clauses.size(); cref++) {
+            for (int lit : clauses[cref]) {
+                if (litValue(lit) == VALUE_TRUE) {
+                    trueCount[cref]++;
+                    trueXor[cref] ^= litVar(lit);
+                }
+            }
+            if (trueCount[cref] == 0) {
+                addUnsat(cref);
+                for (int lit : clauses[cref]) makeCount[litVar(lit)]++;
+            } else if (trueCount[cref] == 1) {
+                breakCount[trueXor[cref]]++;
+            }
+        }
+    }
+
+    void flip(int var) {
+        flips++;
+        value[var] = -value[var];
+        int trueLit = value[var] == VALUE_TRUE ? var : -var;
+
+        for (ClauseRef cref : occurs[trueLit]) {
+            uint32_t before = trueCount[cref]++;
+            trueXor[cref] ^= var;
+            if (before == 0) {
+                removeUnsat(cref);
+                breakCount[var]++;
+                for (int lit : clauses[cref]) makeCount[litVar(lit)]--;
+            } else if (before == 1) {
+                breakCount[trueXor[cref] ^ var]--; // The previously sole true variable
+            }
+        }
+        for (ClauseRef cref : occurs[-trueLit]) {
+            uint32_t after = --trueCount[cref];
+            trueXor[cref] ^= var;
+            if (after == 0) {
+                addUnsat(cref);
+                breakCount[var]--;
+                for (int lit : clauses[cref]) makeCount[litVar(lit)]++;
+            } else if (after == 1) {
+                breakCount[trueXor[cref]]++;
+            }
+        }
+    }
+
+    // ProbSAT: pick a variable of the clause with probability proportional to (eps + break)^-cb
+    int pickProbSAT(ClauseRef cref) {
+        ClauseView clause = clauses[cref];
+        weights.resize(clause.size());
+        double sum = 0;
+        for (uint32_t i = 0; i < clause.size(); i++) {
+            int b = breakCount[litVar(clause[i])];
+            sum += weights[i] = b < SLS_BREAK_TABLE ? probTable[b] : 0.0;
+        }
+        if (sum == 0) return litVar(clause[randomBelow(clause.size())]);
+        double r = randomUnit() * sum;
+        for (uint32_t i = 0; i + 1 < clause.size(); i++) {
+            if ((r -= weights[i]) <= 0) return litVar(clause[i]);
+        }
+        return litVar(clause[clause.size() - 1]);
+    }
+
+    // WalkSAT (SKC): a variable that breaks nothing if there is one, otherwise with probability noise
+    // a random variable, else one with the lowest break count (highest make count on ties)
+    int pickWalkSAT(ClauseRef cref) {
+        ClauseView clause = clauses[cref];
+        int best = 0;
+        for (int lit : clause) {
+            int var = litVar(lit);
+            if (best == 0 || breakCount[var] < breakCount[best] ||
+                (breakCount[var] == breakCount[best] && makeCount[var] > makeCount[best])) {
+                best = var;
+            }
+        }
+        if (breakCount[best] > 0 && randomUnit() < WALKSAT_NOISE) return litVar(clause[randomBelow(clause.size())]);
+        return best;
+    }
+
+    // Flip until every clause is satisfied, maxFlips runs out (0 for no limit) or stop is raised,
+    // starting from phases where they are assigned. Returns true if a model was found, it is then in
+    // value. With keepBest the values closest to a model are also kept in bestValue.
+    bool solve(int rule, uint64_t maxFlips, const std::vector<int8_t>& phases = std::vector<int8_t>(), bool keepBest = false) {
+        if (hasEmptyClause) return false;
+        initialize(phases);
+        bestUnsat = SIZE_MAX;
+        uint64_t limit = maxFlips == 0 ? UINT64_MAX : flips + maxFlips;
+        while (!unsat.empty()) {
+            if (keepBest && unsat.size() < bestUnsat) {
+                bestUnsat = unsat.size();
+                bestValue = value;
+            }
+            if (flips >= limit) return false;
+            if ((flips & 1023) == 0 && stop != nullptr && stop->load(std::memory_order_relaxed)) return false;
+            ClauseRef cref = unsat[randomBelow((uint32_t)unsat.size())];
+            flip(rule == SLS_WALKSAT ? pickWalkSAT(cref) : pickProbSAT(cref));
+        }
+        bestUnsat = 0;
+        if (keepBest) bestValue = value;
+        return true;
+    }
+
+    void model(Assignment& assignment) const {
+        assignment.values.assign(value.begin(), value.end());
+    }
+};
+
+// Bounded WalkSAT bursts inside a systematic search.
+// Every interval conflicts the current partial assignment, completed at random, seeds a burst of a
+// few thousand flips, and the assignment closest to a model that it reached becomes the saved phases
+// of the search. The decisions then head for the region local search found promising, which helps on
+// formulas that are almost satisfied once propagation has run.
+class LocalSearchBursts {
+public:
+    LocalSearch search;
+    uint64_t interval;
+    uint64_t burstFlips;
+    uint64_t nextBurst;
+    uint64_t bursts;
+    uint64_t models; // Bursts that ended on a model
+
+    LocalSearchBursts(const ClauseArena& formula, int numVars, uint64_t conflictInterval, uint64_t flipsPerBurst)
+        : search(formula, numVars), interval(conflictInterval), burstFlips(flipsPerBurst),
+          nextBurst(conflictInterval), bursts(0), models(0) {}
+
+    bool due(uint64_t conflicts) const { return conflicts >= nextBurst; }
+
+    // Run a burst from the given values, returns true if it ended on a model
+    bool run(const std::vector<int8_t>& values, uint64_t conflicts) {
+        bursts++;
+        nextBurst = conflicts + interval;
+        bool found = search.solve(SLS_WALKSAT, burstFlips, values, true);
+        if (found) models++;
+        return found;
+    }
+
+    // Overwrite saved phases with the best assignment of the last burst
+    void savePhases(std::vector<int8_t>& saved) const {
+        if (search.bestValue.empty()) return; // Empty clause, there was nothing to walk on
+        for (int var = 1; var <= search.numVariables; var++) saved[var] = search.bestValue[var];
+    }
+};
+
+// Pick rule named on the command line, -1 if the name is unknown
+inline int slsRule(const std::string& name) {
+    if (name == "probsat") return SLS_PROBSAT;
+    if (name == "walksat") return SLS_WALKSAT;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SUBSUME_H
+#define SUBSUME_H
+
+#include "assignment.h"
+#include <cstdint>
+#include <vector>
+
+#define SUBSUME_FAILED INT32_MAX
+
+// 64-bit summary of the variables of a clause. A clause can only subsume (or strengthen) another whose
+// signature covers its own, which rules out most pairs without looking at their literals.
+inline uint64_t clauseSignature(const int* lits, uint32_t size) {
+    uint64_t signature = 0;
+    for (uint32_t i = 0; i < size; i++) signature |= 1ull << (litVar(lits[i]) & 63);
+    return signature;
+}
+
+// Whether clause c subsumes clause d. Returns 0 if every literal of c is in d, a literal l of c if that
+// holds once l is negated (self-subsuming resolution: -l can be removed from d), SUBSUME_FAILED otherwise.
+// mark is a per-variable scratch table that must be all zero, and is left so.
+inline int subsumes(const int* c, uint32_t cSize, const int* d, uint32_t dSize, std::vector<int>& mark) {
+    for (uint32_t i = 0; i < dSize; i++) mark[litVar(d[i])] = d[i];
+    int flipped = 0;
+    for (uint32_t i = 0; i < cSize; i++) {
+        int m = mark[litVar(c[i])];
+        if (m == c[i]) continue;
+        if (m == -c[i] && flipped == 0) {
+            flipped = c[i];
+            continue;
+        }
+        flipped = SUBSUME_FAILED;
+        break;
+    }
+    for (uint32_t i = 0; i < dSize; i++) mark[litVar(d[i])] = 0;
+    return flipped;
+}
+
+#endif
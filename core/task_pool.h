@@ -0,0 +1,111 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+template <typename T> class TaskPool;
+
+// Slot of a pool, the value is kept alive between uses so its buffers are reused
+template <typename T>
+struct PooledTask {
+    T value;
+    TaskPool<T>* home;  // Pool the slot goes back to
+    PooledTask* next;   // Free list link
+};
+
+// Move-only owner of a pooled task, the slot goes back to its pool when the handle is dropped.
+// Unlike a shared_ptr, passing the handle around never touches a reference count.
+template <typename T>
+class TaskHandle {
+    PooledTask<T>* node;
+
+public:
+    TaskHandle() : node(nullptr) {}
+    explicit TaskHandle(PooledTask<T>* n) : node(n) {}
+    TaskHandle(TaskHandle&& other) noexcept : node(other.node) { other.node = nullptr; }
+    TaskHandle& operator=(TaskHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            node = other.node;
+            other.node = nullptr;
+        }
+        return *this;
+    }
+    TaskHandle(const TaskHandle&) = delete;
+    TaskHandle& operator=(const TaskHandle&) = delete;
+    ~TaskHandle() { reset(); }
+
+    void reset() {
+        if (node != nullptr) {
+            node->home->release(node);
+            node = nullptr;
+        }
+    }
+
+    T& operator*() const { return node->value; }
+    T* operator->() const { return &node->value; }
+    explicit operator bool() const { return node != nullptr; }
+};
+
+// Per-thread task arena.
+// Only the owning thread acquires from the pool, so its free list needs no synchronization. Tasks
+// finished by other threads are pushed on a lock-free return stack, which the owner takes back in
+// one exchange once its own free list runs dry. Slots are allocated in blocks and never freed
+// before the pool itself, which must outlive every handle it gave out. The owner is atomic because a
+// worker adopts its pool while other threads may already be releasing tasks into it.
+template <typename T>
+class TaskPool {
+    static const size_t BLOCK_SIZE = 64;
+
+    std::vector<std::unique_ptr<PooledTask<T>[]>> blocks;
+    PooledTask<T>* freeList;
+    std::atomic<PooledTask<T>*> returned;
+    std::atomic<std::thread::id> owner;
+
+    void grow() {
+        blocks.emplace_back(new PooledTask<T>[BLOCK_SIZE]);
+        PooledTask<T>* block = blocks.back().get();
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            block[i].home = this;
+            block[i].next = freeList;
+            freeList = &block[i];
+        }
+    }
+
+public:
+    TaskPool() : freeList(nullptr), returned(nullptr), owner(std::this_thread::get_id()) {}
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Make the calling thread the owner, before it acquires anything from the pool
+    void adopt() { owner.store(std::this_thread::get_id(), std::memory_order_release); }
+
+    // Take a slot, its value still holds whatever the previous task left in it
+    TaskHandle<T> acquire() {
+        if (freeList == nullptr) {
+            freeList = returned.exchange(nullptr, std::memory_order_acquire);
+            if (freeList == nullptr) grow();
+        }
+        PooledTask<T>* node = freeList;
+        freeList = node->next;
+        return TaskHandle<T>(node);
+    }
+
+    void release(PooledTask<T>* node) {
+        if (std::this_thread::get_id() == owner.load(std::memory_order_acquire)) {
+            node->next = freeList;
+            freeList = node;
+            return;
+        }
+        PooledTask<T>* head = returned.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!returned.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+};
+
+#endif
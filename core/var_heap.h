@@ -0,0 +1,87 @@
+#ifndef VAR_HEAP_H
+#define VAR_HEAP_H
+
+#include <cstddef>
+#include <vector>
+
+// Max-heap of variables ordered by a score array it does not own, ties going to the lower variable.
+// The heap is 4-ary, which halves its depth compared to a binary heap, and every variable knows its
+// position so its score can be raised in place.
+class VarHeap {
+    static const size_t D = 4;
+
+    const std::vector<double>* score;
+    std::vector<int> heap;
+    std::vector<int> indices; // Per variable, position in heap or -1 if absent
+
+    bool before(int a, int b) const {
+        double sa = (*score)[a], sb = (*score)[b];
+        return sa > sb || (sa == sb && a < b);
+    }
+
+    void percolateUp(size_t i) {
+        int var = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / D;
+            if (!before(var, heap[parent])) break;
+            heap[i] = heap[parent];
+            indices[heap[i]] = (int)i;
+            i = parent;
+        }
+        heap[i] = var;
+        indices[var] = (int)i;
+    }
+
+    void percolateDown(size_t i) {
+        int var = heap[i];
+        for (;;) {
+            size_t child = i * D + 1;
+            if (child >= heap.size()) break;
+            size_t last = child + D < heap.size() ? child + D : heap.size();
+            size_t best = child;
+            for (size_t c = child + 1; c < last; c++) {
+                if (before(heap[c], heap[best])) best = c;
+            }
+            if (!before(heap[best], var)) break;
+            heap[i] = heap[best];
+            indices[heap[i]] = (int)i;
+            i = best;
+        }
+        heap[i] = var;
+        indices[var] = (int)i;
+    }
+
+public:
+    explicit VarHeap(const std::vector<double>& s) : score(&s), indices(s.size(), -1) {}
+
+    bool empty() const { return heap.empty(); }
+
+    size_t size() const { return heap.size(); }
+
+    bool contains(int var) const { return indices[var] >= 0; }
+
+    void insert(int var) {
+        if (contains(var)) return;
+        heap.push_back(var);
+        percolateUp(heap.size() - 1);
+    }
+
+    // Restore the order after the score of var went up
+    void increase(int var) {
+        if (contains(var)) percolateUp(indices[var]);
+    }
+
+    int removeMax() {
+        int top = heap[0];
+        indices[top] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            percolateDown(0);
+        }
+        return top;
+    }
+};
+
+#endif
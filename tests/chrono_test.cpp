@@ -0,0 +1,87 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../core/assignment.h"
+#include "../core/clause_arena.h"
+#include "../core/cdcl.h"
+
+// Chronological backtracking only kicks in after CHRONO_MIN_CONFLICTS conflicts on jumps over more than
+// CHRONO_DISTANCE levels, which small instances never reach. This test lowers both so that almost every
+// backjump backtracks chronologically instead, and checks the answers against a solver that always
+// backjumps: models must satisfy the formula, and both must agree on satisfiability.
+
+// Random 3-SAT around the satisfiability threshold, so both answers come up
+static ClauseArena randomFormula(std::mt19937& rng, int numVariables, int numClauses) {
+    ClauseArena formula;
+    std::uniform_int_distribution<int> var(1, numVariables);
+    std::uniform_int_distribution<int> sign(0, 1);
+    for (int i = 0; i < numClauses; i++) {
+        std::vector<int> clause;
+        while (clause.size() < 3) {
+            int v = var(rng);
+            bool repeated = false;
+            for (int lit : clause) repeated = repeated || litVar(lit) == v;
+            if (!repeated) clause.push_back(sign(rng) ? v : -v);
+        }
+        formula.addClause(clause);
+    }
+    return formula;
+}
+
+static bool satisfies(const ClauseArena& formula, const Assignment& assignment) {
+    for (const auto& clause : formula) {
+        bool satisfied = false;
+        for (int lit : clause) {
+            int8_t value = assignment.value(litVar(lit));
+            satisfied = satisfied || (lit > 0 ? value == VALUE_TRUE : value == VALUE_FALSE);
+        }
+        if (!satisfied) return false;
+    }
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(2018);
+    uint64_t chronoBacktracks = 0;
+    int failures = 0;
+    int sat = 0, unsat = 0;
+
+    for (int round = 0; round < 200; round++) {
+        int numVariables = 50 + round % 5 * 25;
+        ClauseArena formula = randomFormula(rng, numVariables, numVariables * 426 / 100);
+
+        CDCLSolver chrono(formula, numVariables);
+        chrono.chronoDistance = 1;
+        chrono.chronoMinConflicts = 0;
+        bool chronoResult = chrono.solve();
+        chronoBacktracks += chrono.chronoBacktracks;
+
+        CDCLSolver backjump(formula, numVariables);
+        backjump.chronoDistance = 0;
+        bool backjumpResult = backjump.solve();
+
+        if (chronoResult != backjumpResult) {
+            std::cout << "Round " << round << ": chronological backtracking answered "
+                      << (chronoResult ? "SAT" : "UNSAT") << ", backjumping " << (backjumpResult ? "SAT" : "UNSAT") << std::endl;
+            failures++;
+        }
+        if (chronoResult && !satisfies(formula, chrono.engine.assignment)) {
+            std::cout << "Round " << round << ": model found with chronological backtracking violates a clause" << std::endl;
+            failures++;
+        }
+        if (chronoResult) sat++;
+        else unsat++;
+    }
+
+    std::cout << sat << " SAT, " << unsat << " UNSAT, " << chronoBacktracks << " chronological backtracks" << std::endl;
+    if (chronoBacktracks == 0) {
+        std::cout << "Chronological backtracking was never used" << std::endl;
+        failures++;
+    }
+    if (failures > 0) {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}